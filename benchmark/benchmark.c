@@ -0,0 +1,15 @@
+#include <string.h>
+
+void noop(void)
+{
+}
+
+int add(int lhs, int rhs)
+{
+    return lhs + rhs;
+}
+
+int length(const char* string)
+{
+    return (int)strlen(string);
+}
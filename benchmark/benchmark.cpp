@@ -0,0 +1,41 @@
+#include <boost/dll.hpp>
+
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// arguments are passed by value since this is how the benchmarks call them
+namespace cpp_benchmark_plugin {
+void noop() { }
+
+int add(int lhs, int rhs)
+{
+    return lhs + rhs;
+}
+
+std::string concat(std::string lhs, std::string rhs) // NOLINT(performance-unnecessary-value-param)
+{
+    return lhs + rhs;
+}
+
+int sum(std::vector<int> values) // NOLINT(performance-unnecessary-value-param)
+{
+    return std::accumulate(values.begin(), values.end(), 0);
+}
+
+int sum_values(std::map<std::string, int> values) // NOLINT(performance-unnecessary-value-param,readability-identifier-naming)
+{
+    int result = 0;
+    for (const auto& [key, value] : values) {
+        result += value;
+    }
+    return result;
+}
+} // namespace cpp_benchmark_plugin
+
+BOOST_DLL_ALIAS(cpp_benchmark_plugin::noop, noop)
+BOOST_DLL_ALIAS(cpp_benchmark_plugin::add, add)
+BOOST_DLL_ALIAS(cpp_benchmark_plugin::concat, concat)
+BOOST_DLL_ALIAS(cpp_benchmark_plugin::sum, sum)
+BOOST_DLL_ALIAS(cpp_benchmark_plugin::sum_values, sum_values)
@@ -0,0 +1,26 @@
+function noop()
+end
+
+function add(lhs, rhs)
+    return lhs + rhs
+end
+
+function concat(lhs, rhs)
+    return lhs .. rhs
+end
+
+function sum(values)
+    local result = 0
+    for _, value in ipairs(values) do
+        result = result + value
+    end
+    return result
+end
+
+function sum_values(values)
+    local result = 0
+    for _, value in pairs(values) do
+        result = result + value
+    end
+    return result
+end
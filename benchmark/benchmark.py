@@ -0,0 +1,21 @@
+import builtins
+
+
+def noop():
+    pass
+
+
+def add(lhs, rhs):
+    return lhs + rhs
+
+
+def concat(lhs, rhs):
+    return lhs + rhs
+
+
+def sum(values):  # pylint: disable=redefined-builtin
+    return builtins.sum(values)
+
+
+def sum_values(values):
+    return builtins.sum(values.values())
@@ -0,0 +1,16 @@
+#!/bin/sh
+
+noop()
+{
+    :
+}
+
+add()
+{
+    echo $(($1 + $2))
+}
+
+concat()
+{
+    echo "${1}${2}"
+}
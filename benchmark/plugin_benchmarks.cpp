@@ -0,0 +1,207 @@
+#include <benchmark/benchmark.h>
+
+#include <ppplugin/plugin.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+const std::vector<int> VECTOR_ARGUMENT(100, 1); // NOLINT(cert-err58-cpp)
+const std::map<std::string, int> MAP_ARGUMENT { // NOLINT(cert-err58-cpp)
+    { "a", 1 }, { "b", 2 }, { "c", 3 }, { "d", 4 }, { "e", 5 }
+};
+
+template <typename P>
+[[nodiscard]] std::optional<P> loadPlugin(benchmark::State& state, const std::filesystem::path& plugin_path)
+{
+    if constexpr (std::is_same_v<P, ppplugin::NoopPlugin>) {
+        return P {};
+    } else {
+        auto plugin = P::load(plugin_path);
+        if (!plugin) {
+            state.SkipWithError(("Unable to load " + plugin_path.string()).c_str());
+            return std::nullopt;
+        }
+        return std::move(*plugin);
+    }
+}
+
+/**
+ * Measure latency and throughput of calling given plugin function.
+ * Arguments are copied for each call to have all plugins receive them
+ * by value since C plugins do not support references.
+ */
+template <typename P, typename ReturnValue, typename... Args>
+void callFunction(benchmark::State& state, const std::filesystem::path& plugin_path,
+    const std::string& function_name, const Args&... args)
+{
+    auto plugin = loadPlugin<P>(state, plugin_path);
+    if (!plugin) {
+        return;
+    }
+    if (auto result = plugin->template call<ReturnValue>(function_name, Args { args }...); !result) {
+        state.SkipWithError(result.error().what().c_str());
+        return;
+    }
+
+    for (auto _ : state) {
+        auto result = plugin->template call<ReturnValue>(function_name, Args { args }...);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename P, typename ReturnValue, typename... Args>
+void registerCall(const std::string& plugin_name, const std::filesystem::path& plugin_path,
+    const std::string& function_name, const Args&... args)
+{
+    benchmark::RegisterBenchmark((plugin_name + "/call/" + function_name).c_str(),
+        [=](benchmark::State& state) {
+            callFunction<P, ReturnValue>(state, plugin_path, function_name, args...);
+        });
+}
+
+template <typename P>
+void registerCommonCalls(const std::string& plugin_name, const std::filesystem::path& plugin_path)
+{
+    registerCall<P, void>(plugin_name, plugin_path, "noop");
+    registerCall<P, int>(plugin_name, plugin_path, "add", 1, 2);
+    registerCall<P, std::string>(plugin_name, plugin_path, "concat", std::string { "abc" }, std::string { "def" });
+}
+
+template <typename P>
+void registerContainerCalls(const std::string& plugin_name, const std::filesystem::path& plugin_path)
+{
+    registerCall<P, int>(plugin_name, plugin_path, "sum", VECTOR_ARGUMENT);
+    registerCall<P, int>(plugin_name, plugin_path, "sum_values", MAP_ARGUMENT);
+}
+
+/**
+ * Resolve function once and call it directly; lower bound for C plugin calls.
+ */
+void cFunctionHandle(benchmark::State& state)
+{
+    auto plugin = loadPlugin<ppplugin::CPlugin>(state, "./c_benchmark.so");
+    if (!plugin) {
+        return;
+    }
+    auto add = plugin->function<int(int, int)>("add");
+    if (!add) {
+        state.SkipWithError(add.error().what().c_str());
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize((*add)(1, 2));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Resolve Lua function once with fixed signature and call it repeatedly.
+ */
+void luaFunction(benchmark::State& state)
+{
+    auto plugin = loadPlugin<ppplugin::LuaPlugin>(state, "./benchmark.lua");
+    if (!plugin) {
+        return;
+    }
+    auto add = plugin->function<int(int, int)>("add");
+    if (!add) {
+        state.SkipWithError(add.error().what().c_str());
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize((*add)(1, 2));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Call Lua function for a batch of arguments; reported per item.
+ */
+void luaBatchCall(benchmark::State& state)
+{
+    constexpr std::size_t BATCH_SIZE = 1000;
+    auto plugin = loadPlugin<ppplugin::LuaPlugin>(state, "./benchmark.lua");
+    if (!plugin) {
+        return;
+    }
+    const std::vector<std::tuple<int, int>> arguments(BATCH_SIZE, { 1, 2 });
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(plugin->callBatch<int>("add", arguments));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(BATCH_SIZE));
+}
+
+void genericBoundCall(benchmark::State& state)
+{
+    auto c_plugin = loadPlugin<ppplugin::CPlugin>(state, "./c_benchmark.so");
+    if (!c_plugin) {
+        return;
+    }
+    ppplugin::Plugin plugin { std::move(*c_plugin) };
+    auto add = plugin.bind<int(int, int)>("add");
+    if (!add) {
+        state.SkipWithError(add.error().what().c_str());
+        return;
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize((*add)(1, 2));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void genericCall(benchmark::State& state)
+{
+    auto c_plugin = loadPlugin<ppplugin::CPlugin>(state, "./c_benchmark.so");
+    if (!c_plugin) {
+        return;
+    }
+    ppplugin::Plugin plugin { std::move(*c_plugin) };
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(plugin.call<int>("add", 1, 2));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    registerCommonCalls<ppplugin::CppPlugin>("cpp", "./cpp_benchmark.so");
+    registerContainerCalls<ppplugin::CppPlugin>("cpp", "./cpp_benchmark.so");
+    registerCommonCalls<ppplugin::LuaPlugin>("lua", "./benchmark.lua");
+    registerContainerCalls<ppplugin::LuaPlugin>("lua", "./benchmark.lua");
+    registerCommonCalls<ppplugin::PythonPlugin>("python", "./benchmark.py");
+    registerContainerCalls<ppplugin::PythonPlugin>("python", "./benchmark.py");
+    registerCommonCalls<ppplugin::ShellPlugin>("shell", "./benchmark.sh");
+    registerCommonCalls<ppplugin::NoopPlugin>("noop", {});
+    registerContainerCalls<ppplugin::NoopPlugin>("noop", {});
+
+    // C does not support std::string and containers
+    registerCall<ppplugin::CPlugin, void>("c", "./c_benchmark.so", "noop");
+    registerCall<ppplugin::CPlugin, int>("c", "./c_benchmark.so", "add", 1, 2);
+    registerCall<ppplugin::CPlugin, int>("c", "./c_benchmark.so", "length", static_cast<const char*>("abcdef"));
+    benchmark::RegisterBenchmark("c/function/add", cFunctionHandle);
+    benchmark::RegisterBenchmark("lua/function/add", luaFunction);
+    benchmark::RegisterBenchmark("lua/batch/add", luaBatchCall);
+    benchmark::RegisterBenchmark("generic/call/add", genericCall);
+    benchmark::RegisterBenchmark("generic/bound/add", genericBoundCall);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
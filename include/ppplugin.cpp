@@ -8,16 +8,25 @@
 #include "ppplugin/expected.h"
 #include "ppplugin/noop_plugin.h"
 #include "ppplugin/plugin.h"
+#include "ppplugin/plugin_handle.h"
 #include "ppplugin/plugin_manager.h"
+#include "ppplugin/plugin_registry.h"
 
 #include "ppplugin/c/plugin.h"
 
 #include "ppplugin/cpp/plugin.h"
 
+#include "ppplugin/lua/lua_allocator.h"
+#include "ppplugin/lua/lua_async_call.h"
+#include "ppplugin/lua/lua_buffer.h"
+#include "ppplugin/lua/lua_function.h"
+#include "ppplugin/lua/lua_function_handle.h"
 #include "ppplugin/lua/lua_helpers.h"
 #include "ppplugin/lua/lua_script.h"
+#include "ppplugin/lua/lua_shared_table.h"
 #include "ppplugin/lua/lua_state.h"
 #include "ppplugin/lua/plugin.h"
+#include "ppplugin/lua/plugin_pool.h"
 
 #include "ppplugin/shell/plugin.h"
 #include "ppplugin/shell/shell_session.h"
@@ -33,6 +42,8 @@
 #include "ppplugin/detail/boost_dll_loader.h"
 #include "ppplugin/detail/compatibility_utils.h"
 #include "ppplugin/detail/compiler_info.h"
+#include "ppplugin/detail/epoch.h"
+#include "ppplugin/detail/file_watcher.h"
 #include "ppplugin/detail/function_details.h"
 #include "ppplugin/detail/scope_guard.h"
 #include "ppplugin/detail/string_utils.h"
@@ -4,13 +4,49 @@
 #include "ppplugin/detail/boost_dll_loader.h"
 #include "ppplugin/errors.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace ppplugin {
 class CPlugin {
 public:
-    [[nodiscard]] static Expected<CPlugin, LoadError> load(const std::filesystem::path& plugin_library_path);
+    template <typename Signature>
+    using Function = detail::boost_dll::Function<Signature>;
+    using LoadOptions = detail::boost_dll::LoadOptions;
+
+    /**
+     * Load shared library from given path.
+     *
+     * @param options control symbol binding and visibility (dlopen flags);
+     *                if LoadOptions::indexSymbols is set, all exported symbols
+     *                are read once and can be queried via symbols() and has()
+     *                and lookups of missing symbols do not reach the dynamic linker
+     */
+    [[nodiscard]] static Expected<CPlugin, LoadError> load(const std::filesystem::path& plugin_library_path, const LoadOptions& options = {});
 
     explicit operator bool() const;
 
+    /**
+     * Sorted list of all symbols exported by the library.
+     * Only available if the plugin was loaded with symbol indexing enabled,
+     * otherwise empty.
+     */
+    [[nodiscard]] const std::vector<std::string>& symbols() const;
+    /**
+     * Check if the library exports a symbol of given name.
+     */
+    [[nodiscard]] bool has(const std::string& symbol_name) const;
+
+    /**
+     * Resolve function of given name once and return a typed handle to it.
+     * Calling the handle does not perform any further symbol lookup.
+     *
+     * @attention The plugin has to be kept alive as long as the handle is used.
+     */
+    template <typename Signature>
+    [[nodiscard]] CallResult<Function<Signature>> function(const std::string& function_name) const;
+
     template <typename ReturnValue, typename... Args>
     [[nodiscard]] CallResult<ReturnValue> call(const std::string& function_name, Args&&... args);
 
@@ -23,9 +59,20 @@ private:
     CPlugin() = default;
 
 private:
-    boost::dll::shared_library plugin_;
+    std::shared_ptr<detail::boost_dll::SharedLibrary> plugin_;
 };
 
+template <typename Signature>
+CallResult<CPlugin::Function<Signature>> CPlugin::function(const std::string& function_name) const
+{
+    static_assert(!std::is_reference_v<typename Function<Signature>::ReturnType>,
+        "C does not support references for its return value!");
+    static_assert(!Function<Signature>::HAS_REFERENCE_ARGUMENT,
+        "C does not support references for its arguments!");
+
+    return detail::boost_dll::getFunction<false, Signature>(plugin_.get(), function_name);
+}
+
 template <typename ReturnValue, typename... Args>
 CallResult<ReturnValue> CPlugin::call(const std::string& function_name, Args&&... args)
 {
@@ -35,15 +82,16 @@ CallResult<ReturnValue> CPlugin::call(const std::string& function_name, Args&&..
         "C does not support references for its arguments! "
         "Consider passing the argument with an explicit cast to the desired type.");
 
-    return detail::boost_dll::call<false, ReturnValue>(
-        plugin_, function_name, std::forward<Args>(args)...);
+    return function<ReturnValue(Args...)>(function_name).andThen([&](const auto& handle) {
+        return handle(std::forward<Args>(args)...);
+    });
 }
 
 // TODO: remove code duplication here and in C++ plugin
 template <typename VariableType>
 CallResult<VariableType> CPlugin::global(const std::string& variable_name)
 {
-    auto result_pointer = detail::boost_dll::getSymbol(plugin_, variable_name);
+    auto result_pointer = detail::boost_dll::getSymbol(plugin_.get(), variable_name);
     if (result_pointer.hasValue()) {
         // raw type casting necessary due to lack of type information in shared library
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
@@ -55,7 +103,7 @@ CallResult<VariableType> CPlugin::global(const std::string& variable_name)
 template <typename VariableType>
 CallResult<void> CPlugin::global(const std::string& variable_name, VariableType&& new_value)
 {
-    auto result_pointer = detail::boost_dll::getSymbol(plugin_, variable_name);
+    auto result_pointer = detail::boost_dll::getSymbol(plugin_.get(), variable_name);
     if (result_pointer.hasValue()) {
         // raw type casting necessary due to lack of type information in shared library
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
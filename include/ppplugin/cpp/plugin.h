@@ -7,12 +7,26 @@
 #include <boost/dll.hpp>
 
 #include <filesystem>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace ppplugin {
 class CppPlugin {
 public:
-    [[nodiscard]] static Expected<CppPlugin, LoadError> load(const std::filesystem::path& plugin_library_path);
+    template <typename Signature>
+    using Function = detail::boost_dll::Function<Signature>;
+    using LoadOptions = detail::boost_dll::LoadOptions;
+
+    /**
+     * Load shared library from given path.
+     *
+     * @param options control symbol binding and visibility (dlopen flags);
+     *                if LoadOptions::indexSymbols is set, all exported symbols
+     *                are read once and can be queried via symbols() and has()
+     *                and lookups of missing symbols do not reach the dynamic linker
+     */
+    [[nodiscard]] static Expected<CppPlugin, LoadError> load(const std::filesystem::path& plugin_library_path, const LoadOptions& options = {});
 
     ~CppPlugin() = default;
     CppPlugin(const CppPlugin&) = default;
@@ -22,6 +36,26 @@ public:
 
     explicit operator bool() const;
 
+    /**
+     * Sorted list of all symbols exported by the library.
+     * Only available if the plugin was loaded with symbol indexing enabled,
+     * otherwise empty.
+     */
+    [[nodiscard]] const std::vector<std::string>& symbols() const;
+    /**
+     * Check if the library exports a symbol of given name.
+     */
+    [[nodiscard]] bool has(const std::string& symbol_name) const;
+
+    /**
+     * Resolve function of given name once and return a typed handle to it.
+     * Calling the handle does not perform any further symbol lookup.
+     *
+     * @attention The plugin has to be kept alive as long as the handle is used.
+     */
+    template <typename Signature>
+    [[nodiscard]] CallResult<Function<Signature>> function(const std::string& function_name) const;
+
     template <typename ReturnValue, typename... Args>
     [[nodiscard]] CallResult<ReturnValue> call(const std::string& function_name, Args&&... args);
 
@@ -34,20 +68,27 @@ private:
     CppPlugin() = default;
 
 private:
-    boost::dll::shared_library plugin_;
+    std::shared_ptr<detail::boost_dll::SharedLibrary> plugin_;
 };
 
+template <typename Signature>
+CallResult<CppPlugin::Function<Signature>> CppPlugin::function(const std::string& function_name) const
+{
+    return detail::boost_dll::getFunction<true, Signature>(plugin_.get(), function_name);
+}
+
 template <typename ReturnValue, typename... Args>
 CallResult<ReturnValue> CppPlugin::call(const std::string& function_name, Args&&... args)
 {
-    return detail::boost_dll::call<true, ReturnValue>(
-        plugin_, function_name, std::forward<Args>(args)...);
+    return function<ReturnValue(Args...)>(function_name).andThen([&](const auto& handle) {
+        return handle(std::forward<Args>(args)...);
+    });
 }
 
 template <typename VariableType>
 CallResult<VariableType> CppPlugin::global(const std::string& variable_name)
 {
-    auto result_pointer = detail::boost_dll::getSymbol(plugin_, variable_name);
+    auto result_pointer = detail::boost_dll::getSymbol(plugin_.get(), variable_name);
     if (result_pointer.hasValue()) {
         // raw type casting necessary due to lack of type information in shared library
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
@@ -59,7 +100,7 @@ CallResult<VariableType> CppPlugin::global(const std::string& variable_name)
 template <typename VariableType>
 CallResult<void> CppPlugin::global(const std::string& variable_name, VariableType&& new_value)
 {
-    auto result_pointer = detail::boost_dll::getSymbol(plugin_, variable_name);
+    auto result_pointer = detail::boost_dll::getSymbol(plugin_.get(), variable_name);
     if (result_pointer.hasValue()) {
         // raw type casting necessary due to lack of type information in shared library
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
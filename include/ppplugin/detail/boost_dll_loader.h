@@ -5,49 +5,200 @@
 
 #include <boost/dll.hpp>
 
+#include <cassert>
+#include <cstdint>
 #include <filesystem>
-#include <optional>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace ppplugin::detail::boost_dll {
+/**
+ * Options for loading a shared library.
+ */
+struct LoadOptions {
+    enum class Binding : std::uint8_t {
+        /**
+         * Resolve function symbols on first call (RTLD_LAZY).
+         * Faster loading, but the first call of each function is slower.
+         */
+        lazy,
+        /**
+         * Resolve all symbols while loading (RTLD_NOW).
+         * Slower loading, but predictable call latency afterwards.
+         */
+        now,
+    };
+
+    Binding binding { Binding::lazy };
+    /**
+     * Make symbols of the library available for symbol resolution of
+     * subsequently loaded libraries (RTLD_GLOBAL instead of RTLD_LOCAL).
+     */
+    bool global { false };
+    /**
+     * Prefer symbols of the library itself over global symbols with
+     * the same name (RTLD_DEEPBIND); ignored if not supported.
+     *
+     * @note not compatible with AddressSanitizer which aborts the process
+     *       when a library is loaded with RTLD_DEEPBIND
+     */
+    bool deepBind { false };
+    /**
+     * Do not unload the library when it is closed (RTLD_NODELETE);
+     * ignored if not supported.
+     */
+    bool noDelete { false };
+    /**
+     * Read all exported symbols once while loading, see SharedLibrary::indexSymbols().
+     * Libraries without readable symbol table (e.g. stripped) are loaded without index.
+     */
+    bool indexSymbols { false };
+};
+
+/**
+ * Shared library with a cache of its resolved symbols.
+ * Symbols that were not found are cached as well, so repeated lookups
+ * of the same name never reach the dynamic linker again.
+ */
+class SharedLibrary {
+public:
+    explicit SharedLibrary(boost::dll::shared_library library);
+
+    ~SharedLibrary() = default;
+    SharedLibrary(const SharedLibrary&) = delete;
+    SharedLibrary(SharedLibrary&&) = delete;
+    SharedLibrary& operator=(const SharedLibrary&) = delete;
+    SharedLibrary& operator=(SharedLibrary&&) = delete;
+
+    [[nodiscard]] bool isLoaded() const { return library_.is_loaded(); }
+
+    [[nodiscard]] const boost::dll::shared_library& raw() const { return library_; }
+
+    /**
+     * Read all exported symbols once from the library file and use them
+     * as index for all following lookups. Symbols which are not part of
+     * the index are reported as missing without querying the dynamic linker.
+     *
+     * @return false if the symbols could not be read (e.g. stripped library);
+     *         lookups will then continue to query each symbol individually
+     */
+    bool indexSymbols();
+
+    [[nodiscard]] bool isIndexed() const { return !symbol_index_.empty(); }
+
+    /**
+     * Sorted list of all exported symbols.
+     * Empty if the symbols were not indexed.
+     */
+    [[nodiscard]] const std::vector<std::string>& symbols() const { return symbol_index_; }
+
+    /**
+     * Check if library exports symbol of given name.
+     */
+    [[nodiscard]] bool has(std::string_view symbol_name) const;
+
+    /**
+     * Return address of symbol with given name.
+     * The result is cached, including the absence of the symbol.
+     */
+    [[nodiscard]] CallResult<void*> symbolAddress(std::string_view symbol_name) const;
+
+private:
+    boost::dll::shared_library library_;
+    // sorted; immutable after loading
+    std::vector<std::string> symbol_index_;
+
+    mutable std::shared_mutex symbols_mutex_;
+    // nullptr for symbols which are not present in the library;
+    // std::less<> enables lookup by std::string_view without allocation
+    mutable std::map<std::string, void*, std::less<>> symbols_;
+};
+
 /**
  * Attempt to load shared library from given path.
  *
- * Returned library object is not necessarily loaded, check
- * boost::dll::shared_library::is_loaded().
+ * Platform-specific decorations (e.g. "lib" prefix and ".so" suffix)
+ * will be tried first.
  */
-[[nodiscard]] std::optional<boost::dll::shared_library> loadSharedLibrary(
-    const std::filesystem::path& plugin_library_path);
+[[nodiscard]] Expected<std::shared_ptr<SharedLibrary>, LoadError> loadSharedLibrary(
+    const std::filesystem::path& plugin_library_path, const LoadOptions& options = {});
 
-[[nodiscard]] CallResult<void*> getFunctionSymbol(const boost::dll::shared_library& library, const std::string& function_name);
-[[nodiscard]] CallResult<void*> getFunctionPointerSymbol(const boost::dll::shared_library& library, const std::string& function_name);
-[[nodiscard]] CallResult<void**> getSymbol(const boost::dll::shared_library& library, const std::string& function_name);
+/**
+ * Check if library at given path exports symbols via BOOST_DLL_ALIAS,
+ * i.e. if it should be loaded as C++ instead of C plugin.
+ */
+[[nodiscard]] bool hasAliasSection(const std::filesystem::path& library_path);
 
-template <bool isPointer, typename ReturnValue, typename... Args>
-[[nodiscard]] CallResult<ReturnValue> call(const boost::dll::shared_library& library, const std::string& function_name, Args&&... args)
-{
-    if constexpr (isPointer) {
-        using FunctionPointerType = ReturnValue (*)(Args...);
-        return getFunctionPointerSymbol(library, function_name).andThen([&](void* symbol_address) {
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-            auto function = reinterpret_cast<FunctionPointerType>(symbol_address);
-            if constexpr (std::is_void_v<ReturnValue>) {
-                function(std::forward<Args>(args)...);
-            } else {
-                return function(std::forward<Args>(args)...);
-            }
-        });
-    } else {
-        using FunctionType = ReturnValue(Args...);
-        return getFunctionSymbol(library, function_name).andThen([&](void* symbol_address) {
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-            auto function = *reinterpret_cast<FunctionType*>(symbol_address);
-            if constexpr (std::is_void_v<ReturnValue>) {
-                function(std::forward<Args>(args)...);
-            } else {
-                return function(std::forward<Args>(args)...);
-            }
-        });
+/**
+ * Resolve symbol of given library; fail with CallErrorCode::notLoaded
+ * if library is nullptr (e.g. plugin was moved from).
+ */
+[[nodiscard]] CallResult<void*> getFunctionSymbol(const SharedLibrary* library, std::string_view function_name);
+[[nodiscard]] CallResult<void*> getFunctionPointerSymbol(const SharedLibrary* library, std::string_view function_name);
+[[nodiscard]] CallResult<void**> getSymbol(const SharedLibrary* library, std::string_view function_name);
+
+/**
+ * Handle to a function of a shared library whose symbol was already resolved.
+ * Calling it is a plain indirect call without any symbol lookup.
+ *
+ * @attention The plugin that created this handle has to be kept alive
+ *            as long as the handle is used.
+ */
+template <typename>
+class Function;
+
+template <typename ReturnValue, typename... Args>
+class Function<ReturnValue(Args...)> {
+public:
+    using ReturnType = ReturnValue;
+    using Pointer = ReturnValue (*)(Args...);
+
+    static constexpr bool HAS_REFERENCE_ARGUMENT = (std::is_reference_v<Args> || ...);
+
+    Function() = default;
+    explicit Function(Pointer function)
+        : function_ { function }
+    {
     }
+
+    explicit operator bool() const { return function_ != nullptr; }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-missing-std-forward)
+    ReturnValue operator()(Args... args) const
+    {
+        assert(function_);
+        return function_(std::forward<Args>(args)...);
+    }
+
+    [[nodiscard]] Pointer pointer() const { return function_; }
+
+private:
+    Pointer function_ {};
+};
+
+/**
+ * Resolve function of given name and return a handle to it.
+ *
+ * @tparam isPointer if true, the symbol is expected to be a variable holding
+ *                   the address of the function (e.g. exported by BOOST_DLL_ALIAS)
+ */
+template <bool isPointer, typename Signature>
+[[nodiscard]] CallResult<Function<Signature>> getFunction(const SharedLibrary* library, std::string_view function_name)
+{
+    auto symbol = isPointer ? getFunctionPointerSymbol(library, function_name)
+                            : getFunctionSymbol(library, function_name);
+    return std::move(symbol).andThen([](void* symbol_address) {
+        // raw type casting necessary due to lack of type information in shared library
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return Function<Signature> { reinterpret_cast<typename Function<Signature>::Pointer>(symbol_address) };
+    });
 }
 
 } // namespace ppplugin::detail::boost_dll
@@ -0,0 +1,138 @@
+#ifndef PPPLUGIN_DETAIL_EPOCH_H
+#define PPPLUGIN_DETAIL_EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace ppplugin::detail::epoch {
+/**
+ * Epoch-based reclamation of objects which are read without locking.
+ *
+ * Readers announce the current global epoch while they access shared
+ * objects (see ReadGuard). Writers unlink an object first and then retire it;
+ * it will only be destroyed once no reader which could still observe it
+ * is active anymore.
+ */
+class Domain {
+public:
+    using Deleter = void (*)(void*);
+
+    /**
+     * Per-thread state of a reader.
+     */
+    struct alignas(64) Record { // NOLINT(readability-magic-numbers); avoid false sharing
+        // 0 if thread is not inside of a read-side critical section
+        std::atomic<std::uint64_t> epoch;
+        std::atomic<bool> inUse;
+        // only accessed by owning thread
+        std::uint32_t nesting;
+        Record* next;
+    };
+
+    ~Domain();
+    Domain(const Domain&) = delete;
+    Domain(Domain&&) = delete;
+    Domain& operator=(const Domain&) = delete;
+    Domain& operator=(Domain&&) = delete;
+
+    /**
+     * Domain shared by all readers and writers of this library.
+     */
+    [[nodiscard]] static Domain& global();
+
+    /**
+     * Record of calling thread; will be released on thread exit.
+     */
+    [[nodiscard]] Record& threadRecord();
+
+    void enter(Record& record)
+    {
+        if (record.nesting++ == 0) {
+            // sequentially consistent to be ordered before loads of shared
+            // objects; ensures that writers scanning the records will see it
+            record.epoch.store(global_epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+        }
+    }
+    void leave(Record& record)
+    {
+        if (--record.nesting == 0) {
+            auto epoch = record.epoch.load(std::memory_order_relaxed);
+            // sequentially consistent to be ordered before the load below;
+            // either a concurrent retire() sees this reader as inactive or
+            // this reader sees the retired object
+            record.epoch.store(0, std::memory_order_seq_cst);
+            // reader entered before latest retire() and might have delayed
+            // destruction; only true once per reader for each retire()
+            if (epoch < latest_retired_epoch_.load(std::memory_order_seq_cst)) {
+                collect();
+            }
+        }
+    }
+
+    /**
+     * Destroy object once all readers which might still access it are done.
+     * The object must already be unreachable for new readers.
+     * If it is still in use, it will be destroyed by the last of these
+     * readers when leaving.
+     */
+    void retire(void* object, Deleter deleter);
+
+    /**
+     * Destroy all retired objects that are no longer accessed by any reader.
+     */
+    void collect();
+
+private:
+    Domain() = default;
+
+    [[nodiscard]] Record* acquireRecord();
+
+    [[nodiscard]] std::uint64_t minimumActiveEpoch() const;
+
+private:
+    struct Retired {
+        void* object;
+        Deleter deleter;
+        std::uint64_t epoch;
+    };
+
+    // 0 is reserved for inactive readers
+    std::atomic<std::uint64_t> global_epoch_ { 1 };
+    // grow-only list, records are reused after thread exit
+    std::atomic<Record*> records_ { nullptr };
+
+    std::mutex retired_mutex_;
+    std::vector<Retired> retired_;
+    // epoch of most recently retired object; readers with an older epoch
+    // collect when leaving
+    std::atomic<std::uint64_t> latest_retired_epoch_ { 0 };
+};
+
+/**
+ * Mark calling thread as reader for the duration of this object's lifetime.
+ * Objects loaded while the guard is alive will not be destroyed before
+ * the guard is destroyed. Guards can be nested.
+ */
+class ReadGuard final {
+public:
+    ReadGuard()
+        : domain_ { &Domain::global() }
+        , record_ { &domain_->threadRecord() }
+    {
+        domain_->enter(*record_);
+    }
+    ~ReadGuard() { domain_->leave(*record_); }
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard(ReadGuard&&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+    ReadGuard& operator=(ReadGuard&&) = delete;
+
+private:
+    Domain* domain_;
+    Domain::Record* record_;
+};
+} // namespace ppplugin::detail::epoch
+
+#endif // PPPLUGIN_DETAIL_EPOCH_H
@@ -0,0 +1,62 @@
+#ifndef PPPLUGIN_DETAIL_FILE_WATCHER_H
+#define PPPLUGIN_DETAIL_FILE_WATCHER_H
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace ppplugin::detail {
+/**
+ * Watch files for modifications in a background thread.
+ * A file counts as modified if it was closed after writing or if another
+ * file was moved to its location (e.g. atomic replacement).
+ *
+ * @note Only supported on Linux (inotify); on other platforms,
+ *       watch() will always fail.
+ */
+class FileWatcher {
+public:
+    using Callback = std::function<void(const std::filesystem::path&)>;
+
+    /**
+     * @param callback will be called from the background thread with the
+     *                 absolute path of each modified file
+     */
+    explicit FileWatcher(Callback callback);
+
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher(FileWatcher&&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    FileWatcher& operator=(FileWatcher&&) = delete;
+
+    /**
+     * Start watching given file.
+     *
+     * @return false if the file cannot be watched
+     */
+    bool watch(const std::filesystem::path& file_path);
+
+private:
+    void run();
+
+    void stop();
+
+private:
+    Callback callback_;
+    int inotify_fd_ { -1 };
+    int stop_fd_ { -1 };
+
+    std::mutex mutex_;
+    // inotify watch descriptor to watched directory
+    std::map<int, std::filesystem::path> directories_;
+    std::set<std::filesystem::path> files_;
+
+    std::thread thread_;
+};
+} // namespace ppplugin::detail
+
+#endif // PPPLUGIN_DETAIL_FILE_WATCHER_H
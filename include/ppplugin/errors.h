@@ -93,6 +93,7 @@ enum class CallErrorCode : std::uint8_t {
     notLoaded,
     symbolNotFound,
     incorrectType,
+    timeout,
 };
 
 [[nodiscard]] static constexpr std::string_view codeToString(CallErrorCode code)
@@ -104,6 +105,8 @@ enum class CallErrorCode : std::uint8_t {
         return "not loaded";
     case CallErrorCode::symbolNotFound:
         return "symbol not found";
+    case CallErrorCode::timeout:
+        return "timeout";
     case CallErrorCode::unknown:
     default:
         return "unknown";
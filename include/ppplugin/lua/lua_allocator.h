@@ -0,0 +1,116 @@
+#ifndef PPPLUGIN_LUA_ALLOCATOR_H
+#define PPPLUGIN_LUA_ALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <limits>
+
+namespace ppplugin {
+/**
+ * Memory allocator of a single Lua state.
+ * Keeps track of the memory in use by the state and fails allocations
+ * which would exceed the configured memory limit. Lua reports such
+ * failures as memory errors to the caller.
+ *
+ * @note Not thread-safe; must not be shared between Lua states.
+ */
+class LuaAllocator {
+public:
+    static constexpr auto NO_LIMIT = std::numeric_limits<std::size_t>::max();
+
+    explicit LuaAllocator(std::size_t memory_limit = NO_LIMIT)
+        : memory_limit_ { memory_limit }
+    {
+    }
+    virtual ~LuaAllocator() = default;
+    LuaAllocator(const LuaAllocator&) = delete;
+    LuaAllocator(LuaAllocator&&) = delete;
+    LuaAllocator& operator=(const LuaAllocator&) = delete;
+    LuaAllocator& operator=(LuaAllocator&&) = delete;
+
+    /**
+     * Allocate, resize or free given block; same semantics as lua_Alloc.
+     *
+     * @return nullptr if new_size is zero or the allocation failed
+     */
+    [[nodiscard]] void* reallocate(void* block, std::size_t old_size, std::size_t new_size);
+
+    /**
+     * Number of bytes currently allocated by the Lua state.
+     */
+    [[nodiscard]] std::size_t memoryUsage() const { return memory_usage_; }
+    [[nodiscard]] std::size_t memoryLimit() const { return memory_limit_; }
+
+protected:
+    [[nodiscard]] virtual void* allocate(std::size_t size) = 0;
+    virtual void deallocate(void* block, std::size_t size) = 0;
+    /**
+     * Resize block to new_size (both sizes are non-zero).
+     * Block must remain unchanged if resizing fails.
+     * If shrinking fails, the block is kept and later deallocated with new_size.
+     * Default implementation allocates a new block and copies the content.
+     */
+    [[nodiscard]] virtual void* resize(void* block, std::size_t old_size, std::size_t new_size);
+
+private:
+    std::size_t memory_limit_;
+    std::size_t memory_usage_ {};
+};
+
+/**
+ * Allocator serving small blocks from per-size-class free lists
+ * which are carved from larger chunks; larger blocks use malloc.
+ * Memory of small blocks is only returned to the system on destruction.
+ */
+class LuaPoolAllocator : public LuaAllocator {
+public:
+    explicit LuaPoolAllocator(std::size_t memory_limit = NO_LIMIT)
+        : LuaAllocator { memory_limit }
+    {
+    }
+    ~LuaPoolAllocator() override;
+    LuaPoolAllocator(const LuaPoolAllocator&) = delete;
+    LuaPoolAllocator(LuaPoolAllocator&&) = delete;
+    LuaPoolAllocator& operator=(const LuaPoolAllocator&) = delete;
+    LuaPoolAllocator& operator=(LuaPoolAllocator&&) = delete;
+
+protected:
+    [[nodiscard]] void* allocate(std::size_t size) override;
+    void deallocate(void* block, std::size_t size) override;
+    [[nodiscard]] void* resize(void* block, std::size_t old_size, std::size_t new_size) override;
+
+    /**
+     * Allocate memory for a new chunk; freed via std::free().
+     *
+     * @return nullptr if the allocation failed
+     */
+    [[nodiscard]] virtual void* allocateChunk(std::size_t size);
+
+private:
+    static constexpr std::size_t SIZE_CLASS_GRANULARITY = 16;
+    static constexpr std::size_t MAXIMUM_POOLED_SIZE = 256;
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    [[nodiscard]] static std::size_t sizeClass(std::size_t size)
+    {
+        return (size - 1) / SIZE_CLASS_GRANULARITY;
+    }
+    /**
+     * Check if block was carved from one of the chunks.
+     */
+    [[nodiscard]] bool isPooled(const void* block) const;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    std::array<FreeBlock*, MAXIMUM_POOLED_SIZE / SIZE_CLASS_GRANULARITY> free_blocks_ {};
+    // linked list of chunks; each chunk starts with a pointer to the previous one
+    void* chunks_ {};
+    std::size_t chunk_used_ { CHUNK_SIZE };
+    // malloc'd blocks which are in use with a pooled size since
+    // moving them into the pool failed while shrinking
+    std::size_t foreign_block_count_ {};
+};
+} // namespace ppplugin
+
+#endif // PPPLUGIN_LUA_ALLOCATOR_H
@@ -0,0 +1,170 @@
+#ifndef PPPLUGIN_LUA_ASYNC_CALL_H
+#define PPPLUGIN_LUA_ASYNC_CALL_H
+
+#include "lua_state.h"
+#include "ppplugin/detail/function_details.h"
+#include "ppplugin/errors.h"
+
+#include <optional>
+#include <utility>
+
+struct lua_State;
+
+namespace ppplugin {
+/**
+ * Call of a Lua function running in its own coroutine.
+ * The function can suspend itself via coroutine.yield(value), e.g. to wait
+ * for the host to perform I/O; the host retrieves the value via yielded()
+ * and continues the function via resume(), whose arguments are returned
+ * by coroutine.yield. Multiple calls can be interleaved on the same state.
+ *
+ * @attention The call must be destroyed before the Lua state
+ *            (i.e. the plugin) it was created from.
+ */
+template <typename ReturnValue>
+class LuaAsyncCall {
+public:
+    LuaAsyncCall() = default;
+    ~LuaAsyncCall() { release(); }
+    LuaAsyncCall(const LuaAsyncCall&) = delete;
+    LuaAsyncCall(LuaAsyncCall&& other) noexcept
+        : state_ { std::exchange(other.state_, nullptr) }
+        , thread_ { std::exchange(other.thread_, nullptr) }
+        , reference_ { other.reference_ }
+        , yielded_count_ { other.yielded_count_ }
+        , result_ { std::move(other.result_) }
+    {
+    }
+    LuaAsyncCall& operator=(const LuaAsyncCall&) = delete;
+    LuaAsyncCall& operator=(LuaAsyncCall&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            state_ = std::exchange(other.state_, nullptr);
+            thread_ = std::exchange(other.thread_, nullptr);
+            reference_ = other.reference_;
+            yielded_count_ = other.yielded_count_;
+            result_ = std::move(other.result_);
+        }
+        return *this;
+    }
+
+    /**
+     * Check if function returned or failed.
+     */
+    [[nodiscard]] bool isFinished() const { return result_.has_value(); }
+
+    /**
+     * Last value passed to coroutine.yield when the function suspended itself.
+     */
+    template <typename T>
+    [[nodiscard]] std::optional<T> yielded()
+    {
+        if (thread_ == nullptr || isFinished() || yielded_count_ == 0) {
+            return std::nullopt;
+        }
+        return LuaState::wrap(thread_).top<T>();
+    }
+
+    /**
+     * Continue suspended function; given arguments will be returned by
+     * the corresponding coroutine.yield call.
+     *
+     * @return error if the call already finished or the function failed
+     */
+    template <typename... Args>
+    [[nodiscard]] CallResult<void> resume(Args&&... args)
+    {
+        if (thread_ == nullptr) {
+            return { CallErrorCode::notLoaded };
+        }
+        if (isFinished()) {
+            return CallError { CallErrorCode::unknown, "Call already finished" };
+        }
+        LuaState::wrap(thread_).discardTop(std::exchange(yielded_count_, 0));
+        run(std::forward<Args>(args)...);
+        if (result_.has_value() && !result_->hasValue()) {
+            return result_->error();
+        }
+        return {};
+    }
+
+    /**
+     * Result of the function once it finished.
+     */
+    [[nodiscard]] CallResult<ReturnValue> result() const
+    {
+        if (!result_.has_value()) {
+            return CallError { CallErrorCode::unknown, "Call not finished yet" };
+        }
+        return *result_;
+    }
+
+private:
+    friend class LuaScript;
+
+    /**
+     * Take ownership of given registry reference to given thread.
+     */
+    LuaAsyncCall(lua_State* state, lua_State* thread, int reference)
+        : state_ { state }
+        , thread_ { thread }
+        , reference_ { reference }
+    {
+    }
+
+    /**
+     * Start or continue coroutine until it yields, returns or fails.
+     */
+    template <typename... Args>
+    void run(Args&&... args)
+    {
+        constexpr auto RETURN_TYPE_COUNT = detail::templates::returnTypeCount<
+            detail::templates::FunctionDetails<ReturnValue()>>();
+
+        auto thread = LuaState::wrap(thread_);
+        if constexpr (sizeof...(Args) > 0) {
+            thread.push(std::forward<Args>(args)...);
+        }
+        int result_count = 0;
+        switch (thread.resume(sizeof...(Args), result_count)) {
+        case LuaState::ResumeStatus::yielded:
+            yielded_count_ = result_count;
+            return;
+        case LuaState::ResumeStatus::failed:
+            result_ = CallError {
+                thread.isExecutionLimitExceeded() ? CallErrorCode::timeout : CallErrorCode::unknown,
+                format("Unable to run function. Error: '{}'", thread.pop<std::string>().value_or("?"))
+            };
+            return;
+        case LuaState::ResumeStatus::finished:
+            // adjust number of results like lua_pcall
+            for (; result_count < static_cast<int>(RETURN_TYPE_COUNT); ++result_count) {
+                thread.push(nullptr);
+            }
+            thread.discardTop(result_count - static_cast<int>(RETURN_TYPE_COUNT));
+            result_ = thread.popResult<ReturnValue>();
+            return;
+        }
+    }
+
+    void release()
+    {
+        if (state_ != nullptr) {
+            // coroutine will be collected if it is still suspended
+            LuaState::wrap(state_).removeFromRegistry(reference_);
+            state_ = nullptr;
+            thread_ = nullptr;
+        }
+    }
+
+private:
+    lua_State* state_ {};
+    lua_State* thread_ {};
+    int reference_ {};
+    int yielded_count_ {};
+    std::optional<CallResult<ReturnValue>> result_;
+};
+} // namespace ppplugin
+
+#endif // PPPLUGIN_LUA_ASYNC_CALL_H
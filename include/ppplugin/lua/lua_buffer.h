@@ -0,0 +1,125 @@
+#ifndef PPPLUGIN_LUA_BUFFER_H
+#define PPPLUGIN_LUA_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ppplugin {
+namespace detail::lua {
+    enum class BufferElementType {
+        int8,
+        uint8,
+        int16,
+        uint16,
+        int32,
+        uint32,
+        int64,
+        uint64,
+        float32,
+        float64,
+    };
+
+    template <typename T>
+    constexpr BufferElementType bufferElementType()
+    {
+        if constexpr (std::is_same_v<T, float>) {
+            return BufferElementType::float32;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return BufferElementType::float64;
+        } else if constexpr (sizeof(T) == sizeof(std::int8_t)) {
+            return std::is_signed_v<T> ? BufferElementType::int8 : BufferElementType::uint8;
+        } else if constexpr (sizeof(T) == sizeof(std::int16_t)) {
+            return std::is_signed_v<T> ? BufferElementType::int16 : BufferElementType::uint16;
+        } else if constexpr (sizeof(T) == sizeof(std::int32_t)) {
+            return std::is_signed_v<T> ? BufferElementType::int32 : BufferElementType::uint32;
+        } else {
+            return std::is_signed_v<T> ? BufferElementType::int64 : BufferElementType::uint64;
+        }
+    }
+
+    /**
+     * Type-erased LuaBuffer as stored in Lua userdata.
+     */
+    struct BufferView {
+        std::shared_ptr<void> storage;
+        void* data;
+        std::size_t size;
+        BufferElementType type;
+    };
+} // namespace detail::lua
+
+/**
+ * Fixed-size array of numbers which is shared between C++ and Lua
+ * without converting it to a Lua table.
+ * In Lua, the buffer supports indexing (starting at 1), assignment of
+ * elements and the length operator; all copies refer to the same memory.
+ * Buffers can be passed as arguments and retrieved as results or globals.
+ *
+ * @note Element access from Lua converts single values; integers which do not
+ *       fit into lua_Integer (large uint64_t) are not represented correctly.
+ */
+template <typename T>
+class LuaBuffer {
+    static_assert((std::is_integral_v<T> || std::is_same_v<T, float> || std::is_same_v<T, double>)
+            && !std::is_same_v<T, bool> && sizeof(T) <= sizeof(std::int64_t),
+        "Only numeric element types are supported!");
+
+public:
+    using value_type = T; // NOLINT(readability-identifier-naming); follow std naming
+
+    LuaBuffer()
+        : LuaBuffer { std::vector<T> {} }
+    {
+    }
+    explicit LuaBuffer(std::size_t size)
+        : LuaBuffer { std::vector<T>(size) }
+    {
+    }
+    explicit LuaBuffer(std::vector<T> values)
+    {
+        auto storage = std::make_shared<std::vector<T>>(std::move(values));
+        data_ = storage->data();
+        size_ = storage->size();
+        storage_ = std::move(storage);
+    }
+
+    [[nodiscard]] T* data() { return data_; }
+    [[nodiscard]] const T* data() const { return data_; }
+    [[nodiscard]] std::size_t size() const { return size_; }
+
+    [[nodiscard]] T& operator[](std::size_t index) { return data_[index]; }
+    [[nodiscard]] const T& operator[](std::size_t index) const { return data_[index]; }
+
+    [[nodiscard]] T* begin() { return data_; }
+    [[nodiscard]] T* end() { return data_ + size_; }
+    [[nodiscard]] const T* begin() const { return data_; }
+    [[nodiscard]] const T* end() const { return data_ + size_; }
+
+private:
+    friend class LuaState;
+
+    explicit LuaBuffer(const detail::lua::BufferView& view)
+        : storage_ { view.storage }
+        , data_ { static_cast<T*>(view.data) }
+        , size_ { view.size }
+    {
+    }
+
+    [[nodiscard]] detail::lua::BufferView view() const
+    {
+        return { storage_, data_, size_, detail::lua::bufferElementType<T>() };
+    }
+
+private:
+    // owner of the memory which is never resized
+    std::shared_ptr<void> storage_;
+    T* data_ {};
+    std::size_t size_ {};
+};
+} // namespace ppplugin
+
+#endif // PPPLUGIN_LUA_BUFFER_H
@@ -0,0 +1,98 @@
+#ifndef PPPLUGIN_LUA_FUNCTION_H
+#define PPPLUGIN_LUA_FUNCTION_H
+
+#include "lua_function_handle.h"
+#include "lua_state.h"
+#include "ppplugin/detail/function_details.h"
+#include "ppplugin/errors.h"
+
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+namespace ppplugin {
+template <typename Signature>
+class LuaFunction;
+
+/**
+ * Lua function with fixed signature which is anchored in the Lua registry.
+ * Argument conversion and number of results are determined at compile time;
+ * a call neither looks up the function nor verifies the stack content,
+ * thus it does not allocate if none of the arguments or results do.
+ * Multiple results are moved into the returned tuple and always removed
+ * from the stack, even if their types do not match.
+ * Copies refer to the same Lua function, each by its own reference.
+ *
+ * @attention The function must be destroyed before the Lua state
+ *            (i.e. the plugin) it was created from.
+ */
+template <typename ReturnValue, typename... Args>
+class LuaFunction<ReturnValue(Args...)> {
+public:
+    LuaFunction() = default;
+
+    explicit operator bool() const { return static_cast<bool>(handle_); }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-missing-std-forward)
+    CallResult<ReturnValue> operator()(Args... args) const
+    {
+        if (!handle_) {
+            return { CallErrorCode::notLoaded };
+        }
+        auto state = LuaState::wrap(handle_.state_);
+        state.pushFromRegistry(handle_.reference_);
+        if constexpr (ARGUMENT_COUNT > 0) {
+            state.push(std::forward<Args>(args)...);
+        }
+        if (auto error = state.pcall(ARGUMENT_COUNT, RETURN_TYPE_COUNT); error != 0) {
+            return state.popCallError(error);
+        }
+        if constexpr (RETURN_TYPE_COUNT > 1) {
+            return popResults(state, std::make_index_sequence<RETURN_TYPE_COUNT> {});
+        } else if constexpr (RETURN_TYPE_COUNT == 1) {
+            if (auto result = state.pop<ReturnValue>(true)) {
+                return CallResult<ReturnValue> { std::move(*result) };
+            }
+            return CallError { CallErrorCode::unknown, "Wrong return type" };
+        } else {
+            return {};
+        }
+    }
+
+private:
+    friend class LuaScript;
+
+    static constexpr auto ARGUMENT_COUNT = sizeof...(Args);
+    static constexpr auto RETURN_TYPE_COUNT = detail::templates::returnTypeCount<
+        detail::templates::FunctionDetails<ReturnValue()>>();
+
+    /**
+     * Pop all results, the last one first, and move them into the tuple.
+     */
+    template <std::size_t... Indices>
+    static CallResult<ReturnValue> popResults(LuaState& state, std::index_sequence<Indices...> /*indices*/)
+    {
+        constexpr auto LAST_INDEX = RETURN_TYPE_COUNT - 1;
+        std::tuple<std::optional<std::tuple_element_t<Indices, ReturnValue>>...> results;
+        // comma fold is evaluated from left to right
+        ((std::get<LAST_INDEX - Indices>(results)
+             = state.pop<std::tuple_element_t<LAST_INDEX - Indices, ReturnValue>>(true)),
+            ...);
+        if ((std::get<Indices>(results).has_value() && ...)) {
+            return CallResult<ReturnValue> { ReturnValue { std::move(*std::get<Indices>(results))... } };
+        }
+        return CallError { CallErrorCode::unknown, "Wrong return type" };
+    }
+
+    explicit LuaFunction(LuaFunctionHandle handle)
+        : handle_ { std::move(handle) }
+    {
+    }
+
+private:
+    LuaFunctionHandle handle_;
+};
+} // namespace ppplugin
+
+#endif // PPPLUGIN_LUA_FUNCTION_H
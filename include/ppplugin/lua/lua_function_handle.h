@@ -0,0 +1,116 @@
+#ifndef PPPLUGIN_LUA_FUNCTION_HANDLE_H
+#define PPPLUGIN_LUA_FUNCTION_HANDLE_H
+
+#include "lua_state.h"
+#include "ppplugin/errors.h"
+
+#include <utility>
+
+struct lua_State;
+
+namespace ppplugin {
+template <typename Signature>
+class LuaFunction;
+
+/**
+ * Handle to a Lua function which is anchored in the Lua registry.
+ * Calling it does not require a lookup of the function by name.
+ * The function stays valid even if the global it was resolved from is
+ * reassigned. Copies anchor the function by a reference of their own.
+ *
+ * @attention The handle must be destroyed before the Lua state
+ *            (i.e. the plugin) it was created from.
+ */
+class LuaFunctionHandle {
+public:
+    LuaFunctionHandle() = default;
+    ~LuaFunctionHandle() { release(); }
+    LuaFunctionHandle(const LuaFunctionHandle& other)
+        : state_ { other.state_ }
+        , reference_ { other.copyReference() }
+    {
+    }
+    LuaFunctionHandle(LuaFunctionHandle&& other) noexcept
+        : state_ { std::exchange(other.state_, nullptr) }
+        , reference_ { other.reference_ }
+    {
+    }
+    LuaFunctionHandle& operator=(const LuaFunctionHandle& other)
+    {
+        if (this != &other) {
+            release();
+            state_ = other.state_;
+            reference_ = other.copyReference();
+        }
+        return *this;
+    }
+    LuaFunctionHandle& operator=(LuaFunctionHandle&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            state_ = std::exchange(other.state_, nullptr);
+            reference_ = other.reference_;
+        }
+        return *this;
+    }
+
+    explicit operator bool() const { return state_ != nullptr; }
+
+    /**
+     * Call function with given arguments.
+     *
+     * @see LuaPlugin::call() for accepted types
+     */
+    template <typename ReturnValue, typename... Args>
+    [[nodiscard]] CallResult<ReturnValue> call(Args&&... args) const;
+
+private:
+    friend class LuaScript;
+    template <typename Signature>
+    friend class LuaFunction;
+
+    /**
+     * Take ownership of given registry reference.
+     */
+    LuaFunctionHandle(lua_State* state, int reference)
+        : state_ { state }
+        , reference_ { reference }
+    {
+    }
+
+    [[nodiscard]] int copyReference() const
+    {
+        if (state_ == nullptr) {
+            return {};
+        }
+        auto state = LuaState::wrap(state_);
+        state.pushFromRegistry(reference_);
+        return state.storeInRegistry();
+    }
+
+    void release()
+    {
+        if (state_ != nullptr) {
+            LuaState::wrap(state_).removeFromRegistry(reference_);
+            state_ = nullptr;
+        }
+    }
+
+private:
+    lua_State* state_ {};
+    int reference_ {};
+};
+
+template <typename ReturnValue, typename... Args>
+CallResult<ReturnValue> LuaFunctionHandle::call(Args&&... args) const
+{
+    if (state_ == nullptr) {
+        return { CallErrorCode::notLoaded };
+    }
+    auto state = LuaState::wrap(state_);
+    state.pushFromRegistry(reference_);
+    return state.callTop<ReturnValue>(std::forward<Args>(args)...);
+}
+} // namespace ppplugin
+
+#endif // PPPLUGIN_LUA_FUNCTION_HANDLE_H
@@ -1,17 +1,68 @@
 #ifndef PPPLUGIN_LUA_SCRIPT_H
 #define PPPLUGIN_LUA_SCRIPT_H
 
+#include "lua_async_call.h"
+#include "lua_function.h"
+#include "lua_function_handle.h"
+#include "lua_shared_table.h"
 #include "lua_state.h"
+#include "ppplugin/detail/template_helpers.h"
 #include "ppplugin/errors.h"
 #include "ppplugin/expected.h"
 
+#include <cstddef>
 #include <filesystem>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
 
 namespace ppplugin {
 class LuaScript {
 public:
+    struct LoadOptions {
+        /**
+         * Run script immediately after loading, see load().
+         */
+        bool autoRun { true };
+        /**
+         * If not empty, the compiled script will be stored in this directory
+         * and reused by subsequent loads as long as the script is unchanged
+         * (same path, modification time and content).
+         *
+         * @attention Bytecode is not verified and crafted bytecode can corrupt
+         *            memory; the directory must only be writable by trusted users.
+         *            On POSIX systems, cache files which are not owned by the
+         *            current user or are writable by others are ignored.
+         */
+        std::filesystem::path bytecodeCacheDirectory;
+        /**
+         * Create allocator for the Lua state of the script,
+         * e.g. LuaPoolAllocator with a memory limit.
+         * If empty, the default allocator of Lua is used.
+         */
+        std::function<std::unique_ptr<LuaAllocator>()> allocator;
+        /**
+         * Limits of each call, including the initial run of the script.
+         */
+        LuaExecutionLimits executionLimits;
+        /**
+         * Mode and parameters of the garbage collector;
+         * loading fails if the mode is not supported by the Lua version.
+         */
+        LuaGarbageCollectorOptions garbageCollector;
+        /**
+         * Read-only tables set as globals before the script runs;
+         * their data is shared instead of copied into the Lua state.
+         */
+        std::map<std::string, LuaSharedTable> sharedGlobals;
+    };
+
     /**
      * Load given Lua script.
      *
@@ -20,6 +71,22 @@ public:
      *                 discovered yet (required execution)
      */
     static Expected<LuaScript, LoadError> load(const std::filesystem::path& script_path, bool auto_run = true);
+    static Expected<LuaScript, LoadError> load(const std::filesystem::path& script_path, const LoadOptions& options);
+    /**
+     * Load Lua script from source code or precompiled bytecode in memory.
+     *
+     * @param chunk_name name of the script used in error messages,
+     *                   see Lua documentation of lua_load
+     * @attention bytecode is not verified; only load bytecode from trusted sources
+     */
+    static Expected<LuaScript, LoadError> loadFromBuffer(
+        std::string_view source_or_bytecode, const std::string& chunk_name, bool auto_run = true);
+    /**
+     * Load Lua script from memory with given options;
+     * LoadOptions::bytecodeCacheDirectory is ignored.
+     */
+    static Expected<LuaScript, LoadError> loadFromBuffer(
+        std::string_view source_or_bytecode, const std::string& chunk_name, const LoadOptions& options);
 
     ~LuaScript() = default;
     LuaScript(const LuaScript&) = delete;
@@ -30,17 +97,86 @@ public:
     template <typename ReturnValue, typename... Args>
     [[nodiscard]] CallResult<ReturnValue> call(const std::string& function_name, Args&&... args);
 
+    /**
+     * Call function once for each element of given range.
+     * An element is either the single argument or a std::tuple of all
+     * arguments of the respective call. The function is only looked up once.
+     *
+     * @return result for each call in order of the arguments
+     */
+    template <typename ReturnValue, typename Arguments>
+    [[nodiscard]] std::vector<CallResult<ReturnValue>> callBatch(
+        const std::string& function_name, const Arguments& arguments);
+
+    /**
+     * Start call of function in a new coroutine and run it until it
+     * yields or returns.
+     *
+     * @see LuaAsyncCall
+     */
+    template <typename ReturnValue, typename... Args>
+    [[nodiscard]] CallResult<LuaAsyncCall<ReturnValue>> callAsync(const std::string& function_name, Args&&... args);
+
+    /**
+     * Resolve function with given name once and return handle to it.
+     */
+    [[nodiscard]] CallResult<LuaFunctionHandle> function(const std::string& function_name);
+    /**
+     * Resolve function with given name once and return typed handle to it.
+     */
+    template <typename Signature>
+    [[nodiscard]] CallResult<LuaFunction<Signature>> function(const std::string& function_name);
+
     template <typename VariableType>
     [[nodiscard]] CallResult<VariableType> global(const std::string& variable_name);
     template <typename VariableType>
     void global(const std::string& variable_name, VariableType&& new_value);
 
+    /**
+     * Abort calls exceeding given limits with CallErrorCode::timeout.
+     */
+    void setExecutionLimits(const LuaExecutionLimits& limits) { state_.setExecutionLimits(limits); }
+
+    /**
+     * Perform step of garbage collection, see LuaState::collectGarbage().
+     */
+    bool collectGarbage(std::size_t step_size = 0) { return state_.collectGarbage(step_size); }
+
+    /**
+     * Keep strings retrieved as std::string_view valid until the returned guard is destroyed.
+     */
+    [[nodiscard]] LuaResultGuard resultGuard() { return LuaResultGuard { state_ }; }
+
+    /**
+     * Allocator of the Lua state or nullptr if the default allocator is used.
+     */
+    [[nodiscard]] const LuaAllocator* allocator() const { return state_.allocator(); }
+
 private:
-    LuaScript();
+    friend class LuaPluginPool;
+
+    explicit LuaScript(std::unique_ptr<LuaAllocator> allocator);
+    /**
+     * Create script with new state and opened standard libraries which is
+     * set up according to given options, but does not contain any code yet.
+     * Fails if the state cannot be created, e.g. due to the memory limit of the allocator.
+     */
+    [[nodiscard]] static Expected<LuaScript, LoadError> create(const LoadOptions& options);
+
+    /**
+     * Compile script to bytecode which can be loaded via loadFromBuffer().
+     */
+    [[nodiscard]] static Expected<std::string, LoadError> compile(const std::filesystem::path& script_path);
 
     [[nodiscard]] bool run();
 
     [[nodiscard]] std::optional<LoadError> loadFile(const std::filesystem::path& lua_file, bool auto_run);
+    /**
+     * Load file like loadFile(), but use bytecode from given cache directory
+     * if it is up-to-date; otherwise compile the file and update the cache.
+     */
+    [[nodiscard]] std::optional<LoadError> loadCachedFile(const std::filesystem::path& lua_file,
+        const std::filesystem::path& cache_directory, bool auto_run);
 
     static void pcall();
 
@@ -65,13 +201,73 @@ private:
 template <typename ReturnValue, typename... Args>
 CallResult<ReturnValue> LuaScript::call(const std::string& function_name, Args&&... args)
 {
-    if (state_.pushGlobal(function_name)) {
-        if (auto function = state_.top<ReturnValue(Args...)>()) {
-            return (*function)(std::forward<Args>(args)...);
-        }
+    if (!state_.pushGlobal(function_name)) {
+        return { CallErrorCode::symbolNotFound };
+    }
+    if (!state_.isFunction()) {
+        state_.discardTop();
         return CallError { CallErrorCode::unknown, "Symbol does not match given type" };
     }
-    return { CallErrorCode::symbolNotFound };
+    return state_.callTop<ReturnValue>(std::forward<Args>(args)...);
+}
+
+template <typename ReturnValue, typename Arguments>
+std::vector<CallResult<ReturnValue>> LuaScript::callBatch(
+    const std::string& function_name, const Arguments& arguments)
+{
+    std::vector<CallResult<ReturnValue>> results;
+    results.reserve(std::size(arguments));
+    if (!state_.pushGlobal(function_name)) {
+        results.resize(std::size(arguments), CallError { CallErrorCode::symbolNotFound });
+        return results;
+    }
+    if (!state_.isFunction()) {
+        state_.discardTop();
+        results.resize(std::size(arguments), CallError { CallErrorCode::incorrectType });
+        return results;
+    }
+    for (const auto& argument : arguments) {
+        // keep function on stack for next call
+        state_.duplicateTop();
+        if constexpr (detail::templates::IsStdTuple<detail::templates::RemoveCvrefT<decltype(argument)>>::value) {
+            results.push_back(std::apply([this](const auto&... tuple_arguments) {
+                return state_.callTop<ReturnValue>(tuple_arguments...);
+            },
+                argument));
+        } else {
+            results.push_back(state_.callTop<ReturnValue>(argument));
+        }
+    }
+    state_.discardTop();
+    return results;
+}
+
+template <typename ReturnValue, typename... Args>
+CallResult<LuaAsyncCall<ReturnValue>> LuaScript::callAsync(const std::string& function_name, Args&&... args)
+{
+    auto* thread = state_.pushThread();
+    // anchor thread in registry to prevent its collection
+    LuaAsyncCall<ReturnValue> async_call { state_.state(), thread, state_.storeInRegistry() };
+    auto thread_state = LuaState::wrap(thread);
+    if (!thread_state.pushGlobal(function_name)) {
+        return { CallErrorCode::symbolNotFound };
+    }
+    if (!thread_state.isFunction()) {
+        return { CallErrorCode::incorrectType };
+    }
+    async_call.run(std::forward<Args>(args)...);
+    if (async_call.isFinished() && !async_call.result_->hasValue()) {
+        return async_call.result_->error();
+    }
+    return async_call;
+}
+
+template <typename Signature>
+CallResult<LuaFunction<Signature>> LuaScript::function(const std::string& function_name)
+{
+    return function(function_name).andThen([](LuaFunctionHandle&& handle) {
+        return LuaFunction<Signature> { std::move(handle) };
+    });
 }
 
 template <typename VariableType>
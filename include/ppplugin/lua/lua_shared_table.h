@@ -0,0 +1,84 @@
+#ifndef PPPLUGIN_LUA_SHARED_TABLE_H
+#define PPPLUGIN_LUA_SHARED_TABLE_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace ppplugin {
+/**
+ * Immutable table which is shared by all Lua states it is pushed to
+ * instead of being copied into each of them, e.g. large constant lookup
+ * tables used by all states of a LuaPluginPool.
+ * In Lua, it is a read-only proxy supporting indexing, the length operator
+ * and pairs(); integer keys 1 to n refer to the array part, string keys to
+ * the fields. Assignments raise an error. For LuaJIT, the global pairs() of
+ * the state is replaced to respect __pairs as in Lua 5.2.
+ * Copies refer to the same data which can be used from multiple threads.
+ *
+ * @note Nested tables are wrapped into a new proxy on each access,
+ *       thus proxies of the same nested table are not equal in Lua.
+ */
+class LuaSharedTable {
+public:
+    using Value = std::variant<bool, std::int64_t, double, std::string, LuaSharedTable>;
+    using Array = std::vector<Value>;
+    // transparent comparison allows lookup without copying the key
+    using Fields = std::map<std::string, Value, std::less<>>;
+
+    LuaSharedTable();
+    explicit LuaSharedTable(Array array);
+    explicit LuaSharedTable(Fields fields);
+    LuaSharedTable(Array array, Fields fields);
+
+    [[nodiscard]] const Array& array() const;
+    [[nodiscard]] const Fields& fields() const;
+
+private:
+    struct Data;
+
+    std::shared_ptr<const Data> data_;
+};
+
+struct LuaSharedTable::Data {
+    Array array;
+    Fields fields;
+};
+
+inline LuaSharedTable::LuaSharedTable()
+    : LuaSharedTable { Array {}, Fields {} }
+{
+}
+
+inline LuaSharedTable::LuaSharedTable(Array array)
+    : LuaSharedTable { std::move(array), Fields {} }
+{
+}
+
+inline LuaSharedTable::LuaSharedTable(Fields fields)
+    : LuaSharedTable { Array {}, std::move(fields) }
+{
+}
+
+inline LuaSharedTable::LuaSharedTable(Array array, Fields fields)
+    : data_ { std::make_shared<const Data>(Data { std::move(array), std::move(fields) }) }
+{
+}
+
+inline const LuaSharedTable::Array& LuaSharedTable::array() const
+{
+    return data_->array;
+}
+
+inline const LuaSharedTable::Fields& LuaSharedTable::fields() const
+{
+    return data_->fields;
+}
+} // namespace ppplugin
+
+#endif // PPPLUGIN_LUA_SHARED_TABLE_H
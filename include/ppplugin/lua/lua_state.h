@@ -1,23 +1,76 @@
 #ifndef PPPLUGIN_LUA_STATE_H
 #define PPPLUGIN_LUA_STATE_H
 
+#include "lua_allocator.h"
+#include "lua_buffer.h"
 #include "lua_helpers.h"
+#include "lua_shared_table.h"
 #include "ppplugin/detail/compatibility_utils.h"
 #include "ppplugin/detail/function_details.h"
 #include "ppplugin/detail/template_helpers.h"
 #include "ppplugin/errors.h"
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
 
 struct lua_State;
 
 namespace ppplugin {
+/**
+ * Limits of a single call into Lua; zero disables the respective limit.
+ */
+struct LuaExecutionLimits {
+    /**
+     * Maximum number of executed Lua VM instructions.
+     */
+    std::uint64_t instructionLimit {};
+    /**
+     * Maximum duration (wall-clock time).
+     */
+    std::chrono::nanoseconds timeLimit {};
+};
+
+enum class LuaGarbageCollectorMode : std::uint8_t {
+    incremental,
+    /**
+     * Only supported by Lua 5.2 and 5.4.
+     */
+    generational,
+};
+
+/**
+ * Configuration of the garbage collector; zero keeps the default of Lua.
+ */
+struct LuaGarbageCollectorOptions {
+    LuaGarbageCollectorMode mode { LuaGarbageCollectorMode::incremental };
+    /**
+     * Growth of memory usage (in percent) after a collection cycle until
+     * the next one starts; only used in incremental mode.
+     */
+    int pause {};
+    /**
+     * Speed of the collector relative to allocations (in percent);
+     * only used in incremental mode.
+     */
+    int stepMultiplier {};
+};
+
 class LuaState {
 public:
     LuaState();
+    /**
+     * Create state which uses given allocator for all its memory.
+     * If allocator is nullptr, the default allocator of Lua is used.
+     *
+     * @note state() will return nullptr if the state could not be created
+     */
+    explicit LuaState(std::unique_ptr<LuaAllocator> allocator);
 
     /**
      * Wrap given state in a LuaState and allow access to methods,
@@ -28,6 +81,11 @@ public:
     [[nodiscard]] lua_State* state() { return state_.get(); }
     [[nodiscard]] const lua_State* state() const { return state_.get(); }
 
+    /**
+     * Allocator of this state or nullptr if the default allocator is used.
+     */
+    [[nodiscard]] const LuaAllocator* allocator() const { return allocator_.get(); }
+
     using LuaCFunction = int (*)(lua_State*);
     template <typename Func>
     using IsLuaCFunction = std::is_invocable_r<int, Func, lua_State*>;
@@ -64,6 +122,68 @@ public:
     template <typename T, std::enable_if_t<std::is_function_v<T>, bool> = true>
     [[nodiscard]] auto top();
 
+    /**
+     * Discard given number of top-most stack values.
+     */
+    void discardTop(int count = 1);
+    /**
+     * Push copy of top-most stack value.
+     */
+    void duplicateTop();
+
+    /**
+     * Call function on top of stack with given arguments and pop its results.
+     * The function will be removed from the stack.
+     */
+    template <typename ReturnValue, typename... Args>
+    [[nodiscard]] CallResult<ReturnValue> callTop(Args&&... args);
+    /**
+     * Pop results of a finished function call.
+     * The number of values on the stack must match the number of return types.
+     */
+    template <typename ReturnValue>
+    [[nodiscard]] CallResult<ReturnValue> popResult();
+    /**
+     * Create error for failed pcall() with given result and pop the error
+     * value the failed call left on the stack.
+     */
+    [[nodiscard]] CallError popCallError(int error);
+
+    /**
+     * Create new thread (coroutine) sharing the globals of this state
+     * and push it to the stack.
+     */
+    [[nodiscard]] lua_State* pushThread();
+
+    enum class ResumeStatus {
+        finished,
+        yielded,
+        failed,
+    };
+    /**
+     * Start or continue the coroutine of this thread state with given
+     * number of arguments on top of the stack.
+     * Afterwards, the stack contains result_count results (finished),
+     * result_count values passed to coroutine.yield (yielded) or
+     * the error message (failed).
+     */
+    [[nodiscard]] ResumeStatus resume(std::size_t argument_count, int& result_count);
+
+    /**
+     * Pop top-most stack value and store it in the registry.
+     *
+     * @return reference to value in registry
+     */
+    [[nodiscard]] int storeInRegistry();
+    /**
+     * Push value referenced by given registry reference to stack.
+     */
+    void pushFromRegistry(int reference);
+    /**
+     * Release value referenced by given registry reference.
+     */
+    void removeFromRegistry(int reference);
+
     /**
      * Mark top-most stack value as global variable with given name.
      */
@@ -97,6 +217,31 @@ public:
      */
     [[nodiscard]] bool isTable();
 
+    /**
+     * Abort all following calls (and resumptions of coroutines created
+     * afterwards) exceeding given limits; the state stays usable.
+     * The limits are checked periodically, thus may be exceeded slightly.
+     */
+    void setExecutionLimits(const LuaExecutionLimits& limits);
+    /**
+     * Check if the last call was aborted due to the execution limits.
+     */
+    [[nodiscard]] bool isExecutionLimitExceeded();
+
+    /**
+     * Configure garbage collector.
+     *
+     * @return false if the mode is not supported by the Lua version
+     */
+    [[nodiscard]] bool setGarbageCollectorOptions(const LuaGarbageCollectorOptions& options);
+    /**
+     * Perform incremental step of garbage collection as if step_size KiB
+     * were allocated; zero performs a single basic step.
+     *
+     * @return true if the step finished a collection cycle (incremental mode only)
+     */
+    bool collectGarbage(std::size_t step_size);
+
     /**
      * Register function handler to be called in case of a Lua panic.
      */
@@ -113,6 +258,10 @@ public:
     );
 
 private:
+    // calls functions directly via pcall()
+    template <typename Signature>
+    friend class LuaFunction;
+
     /**
      * Create non-owning LuaState instance of given state.
      * The given state will remain valid after this instance is destroyed.
@@ -120,6 +269,12 @@ private:
     explicit LuaState(lua_State* state);
 
     [[nodiscard]] std::optional<std::string> topString();
+    /**
+     * Get view of top-most string without copying it.
+     * The string is anchored by the innermost LuaResultGuard;
+     * fails if there is none.
+     */
+    [[nodiscard]] std::optional<std::string_view> topStringView();
     [[nodiscard]] std::optional<bool> topBool();
     [[nodiscard]] std::optional<int> topInt();
     [[nodiscard]] std::optional<double> topDouble();
@@ -130,6 +285,30 @@ private:
     [[nodiscard]] std::optional<T> topMap();
     template <typename T>
     [[nodiscard]] std::optional<T> topArray();
+    template <typename T>
+    [[nodiscard]] std::optional<T> topBuffer();
+    /**
+     * Get buffer if top-most stack value is userdata created by pushBuffer().
+     */
+    [[nodiscard]] std::optional<detail::lua::BufferView> topBufferView();
+    /**
+     * Get table if top-most stack value is userdata created by pushing a LuaSharedTable.
+     */
+    [[nodiscard]] std::optional<LuaSharedTable> topSharedTable();
+
+    /**
+     * Length of top-most table as defined by the Lua length operator
+     * (without metamethods).
+     */
+    [[nodiscard]] std::size_t arrayLength();
+    /**
+     * Number of entries of top-most table.
+     */
+    [[nodiscard]] std::size_t tableSize();
+    /**
+     * Push element at given index of top-most table to stack.
+     */
+    void pushArrayElement(std::size_t index);
 
     /**
      * Check if top-most stack value is of type nil.
@@ -166,6 +345,16 @@ private:
     void pushOne(const std::vector<T>& value);
     template <typename K, typename V>
     void pushOne(const std::map<K, V>& value);
+    template <typename T>
+    void pushOne(const LuaBuffer<T>& value) { pushBuffer(value.view()); }
+    /**
+     * Push buffer as userdata sharing its memory.
+     */
+    void pushBuffer(detail::lua::BufferView buffer);
+    /**
+     * Push table as read-only userdata proxy sharing its data.
+     */
+    void pushOne(const LuaSharedTable& value);
 
     /**
      * Start creation of table.
@@ -190,11 +379,6 @@ private:
      */
     [[nodiscard]] int pcall(std::size_t argument_count, std::size_t return_count);
 
-    /**
-     * Discard top-most stack value.
-     */
-    void discardTop();
-
     /**
      * Push next table item (first key, second value) to stack.
      * Before first call, top-most stack value must be of type table.
@@ -209,9 +393,36 @@ private:
     bool pushNextTableItem(bool is_first_iteration);
 
 private:
+    // must outlive state_
+    std::unique_ptr<LuaAllocator> allocator_;
     std::unique_ptr<lua_State, void (*)(lua_State*)> state_;
 };
 
+/**
+ * Keeps strings returned as std::string_view from calls and globals of
+ * the given state alive until the guard is destroyed.
+ * Without an active guard, retrieving a std::string_view fails.
+ * Guards can be nested; each one releases the strings retrieved during
+ * its lifetime.
+ *
+ * @attention The guard must be destroyed before the Lua state.
+ */
+class LuaResultGuard {
+public:
+    explicit LuaResultGuard(LuaState& state);
+    ~LuaResultGuard();
+    LuaResultGuard(const LuaResultGuard&) = delete;
+    LuaResultGuard(LuaResultGuard&&) = delete;
+    LuaResultGuard& operator=(const LuaResultGuard&) = delete;
+    LuaResultGuard& operator=(LuaResultGuard&&) = delete;
+
+private:
+    lua_State* state_;
+    // number of strings anchored by outer guards
+    std::size_t previous_count_ {};
+    bool is_outermost_ {};
+};
+
 template <typename T, typename... Args>
 void LuaState::push(T&& arg, Args&&... args)
 {
@@ -254,10 +465,16 @@ std::optional<T> LuaState::top()
         return topInt();
     } else if constexpr (std::is_same_v<PlainT, std::string>) {
         return topString();
+    } else if constexpr (std::is_same_v<PlainT, std::string_view>) {
+        return topStringView();
     } else if constexpr (detail::templates::IsSpecializationV<T, std::map>) {
         return topMap<T>();
     } else if constexpr (detail::templates::IsSpecializationV<T, std::vector>) {
         return topArray<T>();
+    } else if constexpr (detail::templates::IsSpecializationV<PlainT, LuaBuffer>) {
+        return topBuffer<PlainT>();
+    } else if constexpr (std::is_same_v<PlainT, LuaSharedTable>) {
+        return topSharedTable();
     } else {
         static_assert(!sizeof(T), "Unsupported type!");
     }
@@ -270,11 +487,50 @@ auto LuaState::top()
     return topFunction<T>();
 }
 
+template <typename ReturnValue, typename... Args>
+CallResult<ReturnValue> LuaState::callTop(Args&&... args)
+{
+    constexpr auto RETURN_TYPE_COUNT = detail::templates::returnTypeCount<
+        detail::templates::FunctionDetails<ReturnValue()>>();
+
+    if constexpr (sizeof...(args) > 0) {
+        push(std::forward<Args>(args)...);
+    }
+    // TODO: proper error checking
+    if (auto error = pcall(sizeof...(args), RETURN_TYPE_COUNT); error != 0) {
+        return popCallError(error);
+    }
+
+    return popResult<ReturnValue>();
+}
+
+template <typename ReturnValue>
+CallResult<ReturnValue> LuaState::popResult()
+{
+    constexpr auto RETURN_TYPE_COUNT = detail::templates::returnTypeCount<
+        detail::templates::FunctionDetails<ReturnValue()>>();
+
+    if constexpr (RETURN_TYPE_COUNT > 1) {
+        if (auto result = PopTuple<ReturnValue>::pop(*this)) {
+            return CallResult<ReturnValue> { *result };
+        }
+        return CallError { CallErrorCode::unknown,
+            "Wrong return type" };
+    } else if constexpr (RETURN_TYPE_COUNT == 1) {
+        if (auto result = pop<ReturnValue>()) {
+            return CallResult<ReturnValue> { *result };
+        }
+        return CallError { CallErrorCode::unknown,
+            "Wrong return type" };
+    } else {
+        return CallResult<void> {};
+    }
+}
+
 template <typename T>
 auto LuaState::topFunction()
 {
     using FunctionDetails = detail::templates::FunctionDetails<T>;
-    constexpr auto RETURN_TYPE_COUNT = detail::templates::returnTypeCount<FunctionDetails>();
 
     auto top_function = [this, function_id = topPointer()](auto&&... args)
         -> CallResult<typename FunctionDetails::ReturnType> {
@@ -282,35 +538,7 @@ auto LuaState::topFunction()
             return CallError { CallErrorCode::unknown,
                 "Invalid stack content" };
         }
-        if constexpr (sizeof...(args) > 0) {
-            push(std::forward<decltype(args)>(args)...);
-        }
-        auto error = pcall(sizeof...(args), RETURN_TYPE_COUNT);
-        // TODO: proper error checking
-        if (error != 0) {
-            return CallError {
-                CallErrorCode::unknown,
-                format("Unable to call function. Code: '{}'. Error: '{}'",
-                    error,
-                    error == 2 ? pop<std::string>().value_or("?") : "")
-            };
-        }
-
-        if constexpr (RETURN_TYPE_COUNT > 1) {
-            if (auto result = PopTuple<typename FunctionDetails::ReturnType>::pop(*this)) {
-                return CallResult<typename FunctionDetails::ReturnType> { *result };
-            }
-            return CallError { CallErrorCode::unknown,
-                "Wrong return type" };
-        } else if constexpr (RETURN_TYPE_COUNT == 1) {
-            if (auto result = pop<typename FunctionDetails::ReturnType>()) {
-                return CallResult<typename FunctionDetails::ReturnType> { *result };
-            }
-            return CallError { CallErrorCode::unknown,
-                "Wrong return type" };
-        } else {
-            return CallResult<void> {};
-        }
+        return callTop<typename FunctionDetails::ReturnType>(std::forward<decltype(args)>(args)...);
     };
     if (isFunction()) {
         return std::optional { top_function };
@@ -348,25 +576,38 @@ std::optional<T> LuaState::topMap()
 template <typename T>
 std::optional<T> LuaState::topArray()
 {
-    // retrieve table as sorted map first since iteration is not guaranteed to
-    // be in correct order
-    auto array_map = topMap<std::map<int, typename T::value_type>>();
-    if (!array_map.has_value()) {
-        // not a table or does not match given type
+    if (!isTable()) {
+        return std::nullopt;
+    }
+    // keys must be exactly 1..n; tables with holes or other keys are no arrays
+    const auto length = arrayLength();
+    if (tableSize() != length) {
         return std::nullopt;
     }
-
     T result;
-    for (auto& [index, value] : *array_map) {
-        if (index - 1 != static_cast<int>(result.size())) { // Lua indices start at 1
-            // keys not continuous, thus it cannot be turned into an array
+    result.reserve(length);
+    for (std::size_t index = 1; index <= length; ++index) { // Lua indices start at 1
+        pushArrayElement(index);
+        auto value = pop<typename T::value_type>(true);
+        if (!value.has_value()) {
             return std::nullopt;
         }
-        result.push_back(std::move(value));
+        result.push_back(*std::move(value));
     }
     return result;
 }
 
+template <typename T>
+std::optional<T> LuaState::topBuffer()
+{
+    if (auto buffer = topBufferView()) {
+        if (buffer->type == detail::lua::bufferElementType<typename T::value_type>()) {
+            return T { *buffer };
+        }
+    }
+    return std::nullopt;
+}
+
 template <typename T>
 void LuaState::pushOne(const std::vector<T>& value)
 {
@@ -4,13 +4,29 @@
 #include "lua_script.h"
 #include "ppplugin/errors.h"
 
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace ppplugin {
 class LuaPlugin {
 public:
+    using LoadOptions = LuaScript::LoadOptions;
+
     [[nodiscard]] static Expected<LuaPlugin, LoadError> load(
         const std::filesystem::path& plugin_library_path, bool auto_run = true);
+    [[nodiscard]] static Expected<LuaPlugin, LoadError> load(
+        const std::filesystem::path& plugin_library_path, const LoadOptions& options);
+    /**
+     * Load plugin from Lua source code or precompiled bytecode in memory.
+     *
+     * @see LuaScript::loadFromBuffer
+     */
+    [[nodiscard]] static Expected<LuaPlugin, LoadError> loadFromBuffer(
+        std::string_view source_or_bytecode, const std::string& chunk_name, bool auto_run = true);
+    [[nodiscard]] static Expected<LuaPlugin, LoadError> loadFromBuffer(
+        std::string_view source_or_bytecode, const std::string& chunk_name, const LoadOptions& options);
 
     ~LuaPlugin() = default;
     LuaPlugin(const LuaPlugin&) = delete;
@@ -30,19 +46,92 @@ public:
      * - int
      * - double
      * - std::string
+     * - std::string_view (result only; requires resultGuard())
      * - const char*
      * - std::tuple
      * - std::vector
      * - std::map
+     * - LuaBuffer (shared with Lua without conversion)
+     * - LuaSharedTable (read-only, shared with Lua without conversion)
      */
     template <typename ReturnValue, typename... Args>
     [[nodiscard]] CallResult<ReturnValue> call(const std::string& function_name, Args&&... args);
 
+    /**
+     * Call function once for each element of given range, e.g.
+     * std::vector<std::tuple<Args...>> or std::span<Arg>.
+     *
+     * @see LuaScript::callBatch
+     */
+    template <typename ReturnValue, typename Arguments>
+    [[nodiscard]] std::vector<CallResult<ReturnValue>> callBatch(
+        const std::string& function_name, const Arguments& arguments)
+    {
+        return script_.callBatch<ReturnValue>(function_name, arguments);
+    }
+
+    /**
+     * Call function in a coroutine which can suspend itself via
+     * coroutine.yield and be resumed later via the returned call.
+     *
+     * @attention The returned call must not outlive this plugin.
+     */
+    template <typename ReturnValue, typename... Args>
+    [[nodiscard]] CallResult<LuaAsyncCall<ReturnValue>> callAsync(const std::string& function_name, Args&&... args)
+    {
+        return script_.callAsync<ReturnValue>(function_name, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Resolve function with given name once for repeated calls.
+     * Calls via the returned handle skip the lookup of the function by name.
+     *
+     * @attention The returned handle must not outlive this plugin.
+     */
+    [[nodiscard]] CallResult<LuaFunctionHandle> function(const std::string& function_name)
+    {
+        return script_.function(function_name);
+    }
+    /**
+     * Resolve function with given name once for repeated calls with fixed
+     * signature, e.g. function<int(int, int)>("add").
+     *
+     * @attention The returned function must not outlive this plugin.
+     */
+    template <typename Signature>
+    [[nodiscard]] CallResult<LuaFunction<Signature>> function(const std::string& function_name)
+    {
+        return script_.function<Signature>(function_name);
+    }
+
     template <typename VariableType>
     [[nodiscard]] CallResult<VariableType> global(const std::string& variable_name);
     template <typename VariableType>
     [[nodiscard]] CallResult<void> global(const std::string& variable_name, VariableType&& new_value);
 
+    /**
+     * Abort all following calls exceeding given limits (e.g. endless loops)
+     * with CallErrorCode::timeout; the plugin remains usable afterwards.
+     */
+    void setExecutionLimits(const LuaExecutionLimits& limits) { script_.setExecutionLimits(limits); }
+
+    /**
+     * Perform incremental step of garbage collection as if step_size KiB
+     * were allocated, e.g. while idle to reduce collection work during calls.
+     *
+     * @return true if the step finished a collection cycle (incremental mode only)
+     */
+    bool collectGarbage(std::size_t step_size = 0) { return script_.collectGarbage(step_size); }
+
+    /**
+     * Strings returned as std::string_view by call() or global() remain
+     * valid until the returned guard is destroyed; without such a guard,
+     * retrieving a std::string_view fails.
+     *
+     * @attention The returned guard must not outlive this plugin.
+     */
+    [[nodiscard]] LuaResultGuard resultGuard() { return script_.resultGuard(); }
+
 private:
     explicit LuaPlugin(LuaScript&& script)
         : script_ { std::move(script) }
@@ -0,0 +1,119 @@
+#ifndef PPPLUGIN_LUA_PLUGIN_POOL_H
+#define PPPLUGIN_LUA_PLUGIN_POOL_H
+
+#include "lua_script.h"
+#include "ppplugin/detail/scope_guard.h"
+#include "ppplugin/errors.h"
+#include "ppplugin/expected.h"
+
+#include <atomic>
+#ifdef PPPLUGIN_CPP17_COMPATIBILITY
+#include <condition_variable>
+#endif // PPPLUGIN_CPP17_COMPATIBILITY
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#ifdef PPPLUGIN_CPP17_COMPATIBILITY
+#include <mutex>
+#endif // PPPLUGIN_CPP17_COMPATIBILITY
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ppplugin {
+/**
+ * Same Lua script loaded into multiple independent Lua states to allow
+ * concurrent calls from multiple threads.
+ * The script is compiled only once; all states are loaded from its bytecode.
+ *
+ * @note Each state has its own globals; modifications of global variables
+ *       within one call are not visible to calls executed by other states.
+ */
+class LuaPluginPool {
+public:
+    /**
+     * Load given Lua script into given number of states.
+     *
+     * @param size number of states; if 0, the number of hardware threads will be used
+     * @param options applied to each state, e.g. the data of shared globals exists
+     *                only once for all states; the script always runs after loading
+     */
+    [[nodiscard]] static Expected<LuaPluginPool, LoadError> load(
+        const std::filesystem::path& script_path, std::size_t size = 0,
+        const LuaScript::LoadOptions& options = {});
+
+    ~LuaPluginPool() = default;
+    LuaPluginPool(const LuaPluginPool&) = delete;
+    LuaPluginPool(LuaPluginPool&&) noexcept = default;
+    LuaPluginPool& operator=(const LuaPluginPool&) = delete;
+    LuaPluginPool& operator=(LuaPluginPool&&) noexcept = default;
+
+    explicit operator bool() const { return !scripts_.empty(); }
+
+    [[nodiscard]] std::size_t size() const { return scripts_.size(); }
+
+    /**
+     * Call function in one of the currently unused states.
+     * If all states are in use, wait until one becomes available.
+     * This function is thread-safe.
+     *
+     * @see LuaPlugin::call() for accepted types
+     */
+    template <typename ReturnValue, typename... Args>
+    [[nodiscard]] CallResult<ReturnValue> call(const std::string& function_name, Args&&... args);
+
+private:
+    /**
+     * Lock-free stack of indices of unused states.
+     * Waiting for an index spins briefly before blocking.
+     */
+    class FreeList {
+    public:
+        explicit FreeList(std::size_t size);
+
+        /**
+         * Remove index from list; wait if list is empty.
+         */
+        [[nodiscard]] std::size_t acquire();
+        /**
+         * Add index which was returned by acquire() back to list.
+         */
+        void release(std::size_t index);
+
+    private:
+        /**
+         * Block until head differs from given (empty) head.
+         */
+        void wait(std::uint64_t empty_head);
+
+    private:
+        // lower 32 bits: index + 1 of first free element (0 if empty);
+        // upper 32 bits: modification counter to avoid ABA problem
+        std::atomic<std::uint64_t> head_;
+        std::unique_ptr<std::atomic<std::uint32_t>[]> next_;
+#ifdef PPPLUGIN_CPP17_COMPATIBILITY
+        // no std::atomic::wait(); only notify if there are blocked threads
+        std::atomic<std::uint32_t> waiter_count_ { 0 };
+        std::mutex mutex_;
+        std::condition_variable available_;
+#endif // PPPLUGIN_CPP17_COMPATIBILITY
+    };
+
+    explicit LuaPluginPool(std::vector<LuaScript>&& scripts);
+
+private:
+    std::vector<LuaScript> scripts_;
+    std::unique_ptr<FreeList> free_list_;
+};
+
+template <typename ReturnValue, typename... Args>
+CallResult<ReturnValue> LuaPluginPool::call(const std::string& function_name, Args&&... args)
+{
+    auto index = free_list_->acquire();
+    const detail::ScopeGuard release_guard { [this, index]() { free_list_->release(index); } };
+    return scripts_[index].call<ReturnValue>(function_name, std::forward<Args>(args)...);
+}
+} // namespace ppplugin
+
+#endif // PPPLUGIN_LUA_PLUGIN_POOL_H
@@ -16,11 +16,101 @@
 #ifndef PPPLUGIN_CPP17_COMPATIBILITY
 #include <concepts>
 #endif // PPPLUGIN_CPP17_COMPATIBILITY
+#include <cassert>
 #include <optional>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <variant>
 
 namespace ppplugin {
+template <typename... Plugins>
+class GenericPlugin;
+
+template <typename Signature>
+class BoundCall;
+
+/**
+ * Call of a specific function of a GenericPlugin with fixed signature.
+ * The active plugin type is resolved once when binding the function,
+ * calls are dispatched via a single indirect call.
+ * For C and C++ plugins, the function symbol is resolved when binding, too.
+ *
+ * @attention The bound call refers to the plugin it was created from and
+ *            must not be used after the plugin was destroyed, moved or assigned.
+ */
+template <typename ReturnValue, typename... Args>
+class BoundCall<ReturnValue(Args...)> {
+public:
+    BoundCall() = default;
+
+    explicit operator bool() const { return thunk_ != nullptr; }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-missing-std-forward)
+    CallResult<ReturnValue> operator()(Args... args) const
+    {
+        assert(thunk_);
+        return thunk_(*this, std::forward<Args>(args)...);
+    }
+
+    [[nodiscard]] const std::string& functionName() const { return function_name_; }
+
+private:
+    template <typename...>
+    friend class GenericPlugin;
+
+    using Thunk = CallResult<ReturnValue> (*)(const BoundCall&, Args...);
+    using Function = detail::boost_dll::Function<ReturnValue(Args...)>;
+
+    template <typename P>
+    [[nodiscard]] static CallResult<BoundCall> create(P& plugin, const std::string& function_name)
+    {
+        // same as CPlugin::function(), but reported for each GenericPlugin
+        // which can hold a C plugin, not only when binding a C plugin
+        static_assert(!std::is_same_v<P, CPlugin> || !std::is_reference_v<ReturnValue>,
+            "C does not support references for its return value!");
+        static_assert(!std::is_same_v<P, CPlugin> || !Function::HAS_REFERENCE_ARGUMENT,
+            "C does not support references for its arguments!");
+
+        BoundCall bound_call;
+        bound_call.plugin_ = &plugin;
+        bound_call.function_name_ = function_name;
+        if constexpr (std::is_same_v<P, CppPlugin> || std::is_same_v<P, CPlugin>) {
+            return plugin.template function<ReturnValue(Args...)>(function_name)
+                .andThen([&bound_call](const Function& function) {
+                    bound_call.function_ = function;
+                    bound_call.thunk_ = &functionThunk;
+                    return std::move(bound_call);
+                });
+        } else {
+            bound_call.thunk_ = &callThunk<P>;
+            return bound_call;
+        }
+    }
+
+    template <typename P>
+    static CallResult<ReturnValue> callThunk(const BoundCall& bound_call, Args... args)
+    {
+        return static_cast<P*>(bound_call.plugin_)->template call<ReturnValue>(bound_call.function_name_, std::forward<Args>(args)...);
+    }
+
+    static CallResult<ReturnValue> functionThunk(const BoundCall& bound_call, Args... args)
+    {
+        if constexpr (std::is_void_v<ReturnValue>) {
+            bound_call.function_(std::forward<Args>(args)...);
+            return {};
+        } else {
+            return bound_call.function_(std::forward<Args>(args)...);
+        }
+    }
+
+private:
+    Thunk thunk_ {};
+    void* plugin_ {};
+    Function function_;
+    std::string function_name_;
+};
+
 #ifndef PPPLUGIN_CPP17_COMPATIBILITY
 template <typename P>
 concept IsPlugin = requires(P plugin) {
@@ -73,6 +163,18 @@ public:
     template <typename ReturnValue, typename... Args>
     [[nodiscard]] CallResult<ReturnValue> call(const std::string& function_name, Args&&... args);
 
+    /**
+     * Bind function with given name and signature for repeated calls
+     * without dispatching on the plugin type each time.
+     * Fails if the plugin resolves functions when binding (C, C++) and
+     * the function does not exist.
+     * Signatures with references do not compile if Plugins contains CPlugin.
+     *
+     * @see BoundCall
+     */
+    template <typename Signature>
+    [[nodiscard]] CallResult<BoundCall<Signature>> bind(const std::string& function_name);
+
     template <typename VariableType>
     [[nodiscard]] CallResult<VariableType> global(const std::string& variable_name);
     template <typename VariableType>
@@ -119,6 +221,17 @@ CallResult<ReturnValue> GenericPlugin<Plugins...>::call(
         plugin_);
 }
 
+template <typename... Plugins>
+template <typename Signature>
+CallResult<BoundCall<Signature>> GenericPlugin<Plugins...>::bind(const std::string& function_name)
+{
+    return std::visit(
+        [&function_name](auto& plugin) {
+            return BoundCall<Signature>::create(plugin, function_name);
+        },
+        plugin_);
+}
+
 template <typename... Plugins>
 template <typename VariableType>
 CallResult<VariableType> GenericPlugin<Plugins...>::global(const std::string& variable_name)
@@ -145,7 +258,7 @@ template <typename... Plugins>
 template <typename P>
 std::optional<std::reference_wrapper<P>> GenericPlugin<Plugins...>::plugin()
 {
-    if (auto* plugin = std::get_if<P>(plugin_)) {
+    if (auto* plugin = std::get_if<P>(&plugin_)) {
         return *plugin;
     }
     return std::nullopt;
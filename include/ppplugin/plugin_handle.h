@@ -0,0 +1,150 @@
+#ifndef PPPLUGIN_PLUGIN_HANDLE_H
+#define PPPLUGIN_PLUGIN_HANDLE_H
+
+#include "ppplugin/detail/epoch.h"
+#include "ppplugin/errors.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace ppplugin {
+/**
+ * Shared handle to a plugin instance which can be replaced at any time,
+ * e.g. when the plugin is reloaded.
+ * All copies of a handle refer to the same, latest instance.
+ *
+ * Reading the current instance is lock-free and does not modify any
+ * shared reference count. A replaced instance is destroyed once all
+ * readers which might still access it are done (epoch-based reclamation)
+ * and all references obtained via get() are released.
+ */
+template <typename P>
+class PluginHandle {
+    struct Instance;
+
+public:
+    /**
+     * Access to the current plugin instance which stays valid for the
+     * lifetime of this object, even if the instance is replaced meanwhile.
+     * Should be short-lived since it delays the destruction of
+     * replaced instances.
+     */
+    class ReadAccess final {
+    public:
+        [[nodiscard]] P& operator*() const { return instance_->plugin; }
+        [[nodiscard]] P* operator->() const { return &instance_->plugin; }
+
+    private:
+        friend class PluginHandle;
+
+        explicit ReadAccess(const std::atomic<Instance*>& instance)
+            : instance_ { instance.load(std::memory_order_seq_cst) }
+        {
+        }
+
+        // must be constructed before loading instance
+        detail::epoch::ReadGuard guard_;
+        Instance* instance_;
+    };
+
+    explicit PluginHandle(P&& plugin)
+        : state_ { std::make_shared<State>(std::move(plugin)) }
+    {
+    }
+
+    /**
+     * Access current plugin instance without taking ownership.
+     */
+    [[nodiscard]] ReadAccess read() const { return ReadAccess { state_->instance }; }
+    [[nodiscard]] ReadAccess operator->() const { return read(); }
+
+    /**
+     * Return current plugin instance and take shared ownership of it.
+     * Unlike read(), this allows to keep using the instance for an
+     * unlimited time, but requires a reference count update.
+     */
+    [[nodiscard]] std::shared_ptr<P> get() const
+    {
+        auto access = read();
+        return { access.instance_->owner, &access.instance_->plugin };
+    }
+
+    /**
+     * Call function on current plugin instance.
+     */
+    template <typename ReturnValue, typename... Args>
+    [[nodiscard]] CallResult<ReturnValue> call(const std::string& function_name, Args&&... args) const
+    {
+        return read()->template call<ReturnValue>(function_name, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Replace current plugin instance by given one.
+     * The previous instance will be destroyed once it is no longer in use.
+     */
+    void replace(P&& new_plugin)
+    {
+        auto* new_instance = Instance::create(std::move(new_plugin));
+        auto* old_instance = state_->instance.exchange(new_instance, std::memory_order_seq_cst);
+        state_->version.fetch_add(1, std::memory_order_release);
+        retire(old_instance);
+    }
+
+    /**
+     * Number of times the plugin instance was replaced.
+     */
+    [[nodiscard]] std::uint64_t version() const
+    {
+        return state_->version.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Instance {
+        explicit Instance(P&& new_plugin)
+            : plugin { std::move(new_plugin) }
+        {
+        }
+
+        [[nodiscard]] static Instance* create(P&& new_plugin)
+        {
+            auto instance = std::make_shared<Instance>(std::move(new_plugin));
+            auto* raw_instance = instance.get();
+            // instance keeps itself alive until it is retired
+            raw_instance->owner = std::move(instance);
+            return raw_instance;
+        }
+
+        P plugin;
+        std::shared_ptr<Instance> owner;
+    };
+
+    static void retire(Instance* instance)
+    {
+        detail::epoch::Domain::global().retire(instance, [](void* retired_instance) {
+            // instance will be destroyed once last reference from get() is released
+            auto owner = std::move(static_cast<Instance*>(retired_instance)->owner);
+        });
+    }
+
+    struct State {
+        explicit State(P&& initial_plugin)
+            : instance { Instance::create(std::move(initial_plugin)) }
+        {
+        }
+        ~State() { retire(instance.load(std::memory_order_relaxed)); }
+        State(const State&) = delete;
+        State(State&&) = delete;
+        State& operator=(const State&) = delete;
+        State& operator=(State&&) = delete;
+
+        std::atomic<Instance*> instance;
+        std::atomic<std::uint64_t> version {};
+    };
+    std::shared_ptr<State> state_;
+};
+} // namespace ppplugin
+
+#endif // PPPLUGIN_PLUGIN_HANDLE_H
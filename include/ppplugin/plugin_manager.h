@@ -3,16 +3,34 @@
 
 #include "ppplugin/c/plugin.h"
 #include "ppplugin/cpp/plugin.h"
-#include "ppplugin/detail/template_helpers.h"
+#include "ppplugin/detail/file_watcher.h"
 #include "ppplugin/errors.h"
 #include "ppplugin/expected.h"
 #include "ppplugin/lua/plugin.h"
 #include "ppplugin/plugin.h"
+#include "ppplugin/plugin_handle.h"
+#include "ppplugin/plugin_registry.h"
 #include "ppplugin/python/plugin.h"
+#include "ppplugin/shell/plugin.h"
 
 #include <boost/dll.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace ppplugin {
@@ -22,16 +40,73 @@ class GenericPluginManager {
         "Plugin manager requires at least one plugin type!");
 
 public:
-    explicit GenericPluginManager(bool auto_reload = false)
+    /**
+     * Plugin type holding any of the managed plugin types.
+     */
+    using ManagedPlugin = GenericPlugin<Plugins...>;
+
+    /**
+     * Options for loading plugins via loadPlugin() or loadAll().
+     */
+    struct LoadOptions {
+        /**
+         * Options for C and C++ plugins.
+         */
+        detail::boost_dll::LoadOptions sharedLibrary;
+    };
+
+    /**
+     * Result of loading a single plugin via loadAll().
+     */
+    struct LoadResult {
+        std::filesystem::path path;
+        Expected<PluginHandle<ManagedPlugin>, LoadError> plugin;
+        std::chrono::steady_clock::duration loadTime;
+    };
+
+    /**
+     * Called from the background thread after each automatic reload with
+     * the absolute path of the plugin and the result of reloading it.
+     */
+    using ReloadCallback = std::function<void(const std::filesystem::path&, const Expected<void, LoadError>&)>;
+
+    /**
+     * @param auto_reload if true, plugins loaded via loadPlugin() or loadAll()
+     *                    will be reloaded in the background when their file
+     *                    is modified using their original load options;
+     *                    see PluginHandle for the replacement semantics;
+     *                    loading fails if the file cannot be watched
+     * @param on_reload optional callback to observe reloads, e.g. failures
+     *                  due to a broken file which keep the current instance
+     */
+    explicit GenericPluginManager(bool auto_reload = false, ReloadCallback on_reload = {})
         : auto_reload_ { auto_reload }
     {
+        if (auto_reload_) {
+            reload_state_ = std::make_unique<ReloadState>();
+            reload_state_->onReload = std::move(on_reload);
+            file_watcher_ = std::make_unique<detail::FileWatcher>(
+                [state = reload_state_.get()](const std::filesystem::path& modified_file) {
+                    reloadPlugin(*state, modified_file);
+                });
+        }
     }
 
     virtual ~GenericPluginManager() = default;
-    GenericPluginManager(const GenericPluginManager&) = default;
+    GenericPluginManager(const GenericPluginManager&) = delete;
     GenericPluginManager(GenericPluginManager&&) noexcept = default;
-    GenericPluginManager& operator=(const GenericPluginManager&) = default;
-    GenericPluginManager& operator=(GenericPluginManager&&) noexcept = default;
+    GenericPluginManager& operator=(const GenericPluginManager&) = delete;
+    GenericPluginManager& operator=(GenericPluginManager&& other) noexcept
+    {
+        if (this != &other) {
+            // stop watching before the reload state used by the watcher is destroyed
+            file_watcher_ = std::move(other.file_watcher_);
+            reload_state_ = std::move(other.reload_state_);
+            auto_reload_ = other.auto_reload_;
+            registry_ = std::move(other.registry_);
+        }
+        return *this;
+    }
 
     /**
      * Load Lua script from given path.
@@ -61,9 +136,10 @@ public:
      *            Failure to do so will result in a SEGFAULT.
      */
     [[nodiscard]] Expected<CppPlugin, LoadError> loadCppPlugin(
-        const std::filesystem::path& plugin_library_path)
+        const std::filesystem::path& plugin_library_path,
+        const CppPlugin::LoadOptions& options = {})
     {
-        return CppPlugin::load(plugin_library_path);
+        return CppPlugin::load(plugin_library_path, options);
     }
     /**
      * Load a C plugin from given library path.
@@ -71,24 +147,325 @@ public:
      * as 'extern "C"'.
      */
     [[nodiscard]] Expected<CPlugin, LoadError> loadCPlugin(
-        const std::filesystem::path& plugin_library_path)
+        const std::filesystem::path& plugin_library_path,
+        const CPlugin::LoadOptions& options = {})
+    {
+        return CPlugin::load(plugin_library_path, options);
+    }
+
+    /**
+     * Load plugin from given path and register it under its file name
+     * without extension, see loadPlugin(const std::filesystem::path&, std::string, const LoadOptions&).
+     */
+    [[nodiscard]] Expected<PluginHandle<ManagedPlugin>, LoadError> loadPlugin(
+        const std::filesystem::path& plugin_path, const LoadOptions& options = {})
+    {
+        return loadPlugin(plugin_path, plugin_path.stem().string(), options);
+    }
+
+    /**
+     * Load plugin from given path and register it under given name.
+     * The plugin type is determined by the file extension:
+     * ".lua" for Lua, ".py" for Python, ".sh" for shell scripts and
+     * shared libraries which are loaded as C++ plugin if they export
+     * symbols via BOOST_DLL_ALIAS, otherwise as C plugin.
+     * Only plugin types managed by this manager are loaded, others fail
+     * with LoadErrorCode::fileInvalid.
+     * A plugin which was previously registered under the same name will be
+     * replaced in the registry; its handles stay valid.
+     *
+     * @note If auto-reload is enabled, shared libraries should be replaced
+     *       by moving the new file to their location instead of overwriting
+     *       them since the old version is still mapped into memory.
+     */
+    [[nodiscard]] Expected<PluginHandle<ManagedPlugin>, LoadError> loadPlugin(
+        const std::filesystem::path& plugin_path, std::string name, const LoadOptions& options = {})
+    {
+        return loadHandle(plugin_path, options).andThen([this, &name](PluginHandle<ManagedPlugin>&& handle) {
+            registry_.insert(std::move(name), handle);
+            return std::move(handle);
+        });
+    }
+
+    /**
+     * Load all plugins in given directory concurrently.
+     * Sub-directories and files of unknown or unmanaged type are ignored.
+     *
+     * @return single failed result for the directory itself if it could not be read
+     * @see loadAll(const std::vector<std::filesystem::path>&, std::size_t, const LoadOptions&)
+     */
+    [[nodiscard]] std::vector<LoadResult> loadAll(
+        const std::filesystem::path& plugin_directory, std::size_t thread_count = 0,
+        const LoadOptions& options = {})
+    {
+        std::vector<std::filesystem::path> plugin_paths;
+        std::error_code error;
+        for (std::filesystem::directory_iterator iterator { plugin_directory, error };
+             !error && iterator != std::filesystem::directory_iterator {}; iterator.increment(error)) {
+            if (iterator->is_regular_file() && isPlugin(iterator->path())) {
+                plugin_paths.push_back(iterator->path());
+            }
+        }
+        if (error) {
+            auto code = error == std::errc::no_such_file_or_directory
+                ? LoadErrorCode::fileNotFound
+                : LoadErrorCode::fileNotReadable;
+            std::vector<LoadResult> results;
+            results.push_back(LoadResult { plugin_directory, LoadError { code, error.message() }, {} });
+            return results;
+        }
+        // directory iteration order is unspecified
+        std::sort(plugin_paths.begin(), plugin_paths.end());
+        return loadAll(plugin_paths, thread_count, options);
+    }
+
+    /**
+     * Load all given plugins concurrently, see loadPlugin().
+     * Successfully loaded plugins are registered under their file name
+     * without extension in the order of the given paths.
+     * Python plugins are loaded one after the other since the creation
+     * of interpreters is serialized by the global interpreter lock anyway.
+     *
+     * @param thread_count number of worker threads; if 0, the number of
+     *                     hardware threads will be used
+     * @return load result for each plugin in the same order as the given paths
+     */
+    [[nodiscard]] std::vector<LoadResult> loadAll(
+        const std::vector<std::filesystem::path>& plugin_paths, std::size_t thread_count = 0,
+        const LoadOptions& options = {})
+    {
+        if (thread_count == 0) {
+            thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+        }
+        thread_count = std::min(thread_count, plugin_paths.size());
+
+        // LoadResult is not default constructible; fill slots in parallel
+        std::vector<std::optional<LoadResult>> results(plugin_paths.size());
+        std::atomic<std::size_t> next_index { 0 };
+        std::mutex python_mutex;
+        auto worker = [&]() {
+            for (auto index = next_index++; index < plugin_paths.size(); index = next_index++) {
+                const auto& path = plugin_paths[index];
+                std::unique_lock python_lock { python_mutex, std::defer_lock };
+                if (path.extension() == ".py") {
+                    python_lock.lock();
+                }
+                auto start = std::chrono::steady_clock::now();
+                auto plugin = loadHandle(path, options);
+                auto load_time = std::chrono::steady_clock::now() - start;
+                results[index].emplace(LoadResult { path, std::move(plugin), load_time });
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back(worker);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::vector<LoadResult> final_results;
+        final_results.reserve(results.size());
+        for (auto& result : results) {
+            if (result->plugin) {
+                registry_.insert(result->path.stem().string(), *result->plugin);
+            }
+            final_results.push_back(std::move(*result));
+        }
+        return final_results;
+    }
+
+    /**
+     * Find loaded plugin by the name it was registered under.
+     *
+     * @note Must not be called concurrently with loading plugins.
+     */
+    [[nodiscard]] std::optional<std::reference_wrapper<const PluginHandle<ManagedPlugin>>> get(
+        std::string_view name) const
+    {
+        return registry_.get(name);
+    }
+
+    /**
+     * All registered plugins in load order.
+     */
+    [[nodiscard]] const PluginRegistry<ManagedPlugin>& plugins() const { return registry_; }
+
+private:
+    /**
+     * Plugins that will be reloaded on change, by absolute path.
+     */
+    struct ReloadState {
+        struct Entry {
+            PluginHandle<ManagedPlugin> plugin;
+            LoadOptions options;
+        };
+
+        std::mutex mutex;
+        std::map<std::filesystem::path, Entry> plugins;
+        // not modified after construction
+        ReloadCallback onReload;
+    };
+
+    template <typename P>
+    static constexpr bool IS_MANAGED = (std::is_same_v<P, Plugins> || ...);
+
+    [[nodiscard]] Expected<PluginHandle<ManagedPlugin>, LoadError> loadHandle(
+        const std::filesystem::path& plugin_path, const LoadOptions& options)
+    {
+        return createPlugin(plugin_path, options).andThen([this, &plugin_path, &options](ManagedPlugin&& plugin) {
+            PluginHandle<ManagedPlugin> handle { std::move(plugin) };
+            Expected<PluginHandle<ManagedPlugin>, LoadError> result { handle };
+            if (auto_reload_) {
+                if (auto watched = watchPlugin(plugin_path, handle, options); !watched) {
+                    result = std::move(watched).error();
+                }
+            }
+            return result;
+        });
+    }
+
+    [[nodiscard]] static Expected<ManagedPlugin, LoadError> createPlugin(
+        const std::filesystem::path& plugin_path, [[maybe_unused]] const LoadOptions& options)
+    {
+        [[maybe_unused]] auto to_plugin = [](auto&& plugin) {
+            return ManagedPlugin { std::forward<decltype(plugin)>(plugin) };
+        };
+        [[maybe_unused]] auto extension = plugin_path.extension();
+        if constexpr (IS_MANAGED<LuaPlugin>) {
+            if (extension == ".lua") {
+                return LuaPlugin::load(plugin_path).andThen(to_plugin);
+            }
+        }
+        if constexpr (IS_MANAGED<PythonPlugin>) {
+            if (extension == ".py") {
+                return PythonPlugin::load(plugin_path).andThen(to_plugin);
+            }
+        }
+        if constexpr (IS_MANAGED<ShellPlugin>) {
+            if (extension == ".sh") {
+                return ShellPlugin::load(plugin_path).andThen(to_plugin);
+            }
+        }
+        if (isSharedLibrary(plugin_path)) {
+            if constexpr (IS_MANAGED<CppPlugin>) {
+                // C++ plugins can call C functions as well
+                if (!IS_MANAGED<CPlugin> || detail::boost_dll::hasAliasSection(plugin_path)) {
+                    return CppPlugin::load(plugin_path, options.sharedLibrary).andThen(to_plugin);
+                }
+            }
+            if constexpr (IS_MANAGED<CPlugin>) {
+                return CPlugin::load(plugin_path, options.sharedLibrary).andThen(to_plugin);
+            }
+        }
+        return LoadError { LoadErrorCode::fileInvalid, "Unknown plugin type" };
+    }
+
+    [[nodiscard]] Expected<void, LoadError> watchPlugin(const std::filesystem::path& plugin_path,
+        const PluginHandle<ManagedPlugin>& handle, const LoadOptions& options)
+    {
+        std::error_code error;
+        auto absolute_path = std::filesystem::weakly_canonical(plugin_path, error);
+        if (error) {
+            return LoadError { LoadErrorCode::fileNotReadable, "Cannot watch plugin for auto-reload: " + error.message() };
+        }
+        {
+            const std::lock_guard lock { reload_state_->mutex };
+            reload_state_->plugins.insert_or_assign(absolute_path, typename ReloadState::Entry { handle, options });
+        }
+        if (!file_watcher_->watch(absolute_path)) {
+            const std::lock_guard lock { reload_state_->mutex };
+            reload_state_->plugins.erase(absolute_path);
+            return LoadError { LoadErrorCode::unknown, "Cannot watch plugin for auto-reload" };
+        }
+        return {};
+    }
+
+    /**
+     * Reload plugin of given path and replace its current instance.
+     * If loading fails (e.g. file is incomplete), the current instance is kept.
+     */
+    static void reloadPlugin(ReloadState& state, const std::filesystem::path& plugin_path)
+    {
+        std::optional<typename ReloadState::Entry> entry;
+        {
+            const std::lock_guard lock { state.mutex };
+            auto plugin = state.plugins.find(plugin_path);
+            if (plugin == state.plugins.end()) {
+                return;
+            }
+            entry = plugin->second;
+        }
+        auto result = createReloadedPlugin(plugin_path, entry->options).andThen([&entry](ManagedPlugin&& new_plugin) {
+            entry->plugin.replace(std::move(new_plugin));
+        });
+        if (state.onReload) {
+            state.onReload(plugin_path, result);
+        }
+    }
+
+    /**
+     * Load new version of plugin for auto-reload.
+     * Shared libraries are loaded from a unique temporary copy since loading
+     * the same path again would return the already loaded old version.
+     * The copy is removed right after loading; the loaded library stays mapped.
+     */
+    [[nodiscard]] static Expected<ManagedPlugin, LoadError> createReloadedPlugin(
+        const std::filesystem::path& plugin_path, const LoadOptions& options)
+    {
+        if (!isSharedLibrary(plugin_path)) {
+            return createPlugin(plugin_path, options);
+        }
+        static std::atomic<std::uint64_t> reload_count { 0 };
+        std::error_code error;
+        auto copy_path = std::filesystem::temp_directory_path(error);
+        if (error) {
+            return LoadError { LoadErrorCode::fileNotReadable, error.message() };
+        }
+        // keep extension to load copy as the same plugin type
+        copy_path /= "ppplugin_" + plugin_path.stem().string() + "_"
+            + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_"
+            + std::to_string(reload_count++) + plugin_path.extension().string();
+        if (!std::filesystem::copy_file(plugin_path, copy_path, error)) {
+            return LoadError { LoadErrorCode::fileNotReadable, error.message() };
+        }
+        auto plugin = createPlugin(copy_path, options);
+        std::filesystem::remove(copy_path, error);
+        return plugin;
+    }
+
+    [[nodiscard]] static bool isSharedLibrary(const std::filesystem::path& path)
+    {
+        if constexpr (IS_MANAGED<CPlugin> || IS_MANAGED<CppPlugin>) {
+            auto extension = path.extension();
+            return extension == ".so" || extension == ".dll" || extension == ".dylib";
+        }
+        return false;
+    }
+    [[nodiscard]] static bool isPlugin(const std::filesystem::path& path)
     {
-        return CPlugin::load(plugin_library_path);
+        auto extension = path.extension();
+        return (IS_MANAGED<LuaPlugin> && extension == ".lua")
+            || (IS_MANAGED<PythonPlugin> && extension == ".py")
+            || (IS_MANAGED<ShellPlugin> && extension == ".sh")
+            || isSharedLibrary(path);
     }
 
 private:
-    using PluginVariant = typename detail::templates::WrapParameterPack<std::variant, std::shared_ptr, Plugins...>::Type;
-    // store for each plugin its shared library to avoid that the lib will be
-    // unloaded; this might cause segfaults when accessing the plugin
-    std::vector<PluginVariant> plugins_;
+    PluginRegistry<ManagedPlugin> registry_;
 
     /**
      * Auto-reload plugins on change on disk.
      */
-    bool auto_reload_; // TODO: implement me :)
+    bool auto_reload_;
+    std::unique_ptr<ReloadState> reload_state_;
+    // declared last to stop watching before the state is destroyed
+    std::unique_ptr<detail::FileWatcher> file_watcher_;
 };
 
-using PluginManager = GenericPluginManager<Plugin>;
+using PluginManager = GenericPluginManager<CPlugin, CppPlugin, LuaPlugin, PythonPlugin, ShellPlugin, NoopPlugin>;
 } // namespace ppplugin
 
 #endif // PPPLUGIN_PLUGIN_MANAGER_H
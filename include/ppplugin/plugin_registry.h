@@ -0,0 +1,137 @@
+#ifndef PPPLUGIN_PLUGIN_REGISTRY_H
+#define PPPLUGIN_PLUGIN_REGISTRY_H
+
+#include "ppplugin/plugin_handle.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ppplugin {
+/**
+ * Plugin handles indexed by name.
+ * Entries are stored contiguously in insertion order; the lookup uses a
+ * flat open-addressing hash table (linear probing) of indices into them.
+ *
+ * @note Not thread-safe; lookups must not happen concurrently with insertions.
+ */
+template <typename P>
+class PluginRegistry {
+public:
+    struct Entry {
+        std::string name;
+        PluginHandle<P> plugin;
+    };
+    using ConstIterator = typename std::vector<Entry>::const_iterator;
+
+    /**
+     * Add plugin with given name.
+     * If there already is a plugin with the same name, its handle will be
+     * replaced while keeping its original position in the insertion order.
+     *
+     * @return true if name was not registered before
+     */
+    bool insert(std::string name, PluginHandle<P> plugin)
+    {
+        auto hash = hashName(name);
+        if (auto index = find(name, hash)) {
+            entries_[*index].plugin = std::move(plugin);
+            return false;
+        }
+        // keep load factor below 3/4
+        if ((entries_.size() + 1) * 4 > slots_.size() * 3) {
+            rehash(std::max<std::size_t>(slots_.size() * 2, MINIMUM_SLOT_COUNT));
+        }
+        entries_.push_back(Entry { std::move(name), std::move(plugin) });
+        insertSlot(Slot { hash, static_cast<std::uint32_t>(entries_.size()) });
+        return true;
+    }
+
+    /**
+     * Find plugin with given name.
+     */
+    [[nodiscard]] std::optional<std::reference_wrapper<const PluginHandle<P>>> get(std::string_view name) const
+    {
+        if (auto index = find(name, hashName(name))) {
+            return entries_[*index].plugin;
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] bool contains(std::string_view name) const { return find(name, hashName(name)).has_value(); }
+
+    [[nodiscard]] std::size_t size() const { return entries_.size(); }
+    [[nodiscard]] bool empty() const { return entries_.empty(); }
+
+    /**
+     * Iterate entries in insertion order.
+     */
+    [[nodiscard]] ConstIterator begin() const { return entries_.begin(); }
+    [[nodiscard]] ConstIterator end() const { return entries_.end(); }
+
+private:
+    struct Slot {
+        // hash of name to skip most string comparisons
+        std::uint32_t hash;
+        // index into entries_ plus one; 0 marks an empty slot
+        std::uint32_t entry;
+    };
+    static constexpr std::size_t MINIMUM_SLOT_COUNT = 16;
+
+    [[nodiscard]] static std::uint32_t hashName(std::string_view name)
+    {
+        constexpr auto HASH_SHIFT = 32U;
+        auto hash = std::hash<std::string_view> {}(name);
+        // fold to 32 bit; platforms with 32 bit size_t use full hash
+        return static_cast<std::uint32_t>(hash ^ (static_cast<std::uint64_t>(hash) >> HASH_SHIFT));
+    }
+
+    [[nodiscard]] std::optional<std::size_t> find(std::string_view name, std::uint32_t hash) const
+    {
+        if (slots_.empty()) {
+            return std::nullopt;
+        }
+        const auto mask = slots_.size() - 1;
+        for (auto position = hash & mask;; position = (position + 1) & mask) {
+            const auto& slot = slots_[position];
+            if (slot.entry == 0) {
+                return std::nullopt;
+            }
+            if (slot.hash == hash && entries_[slot.entry - 1].name == name) {
+                return slot.entry - 1;
+            }
+        }
+    }
+
+    void insertSlot(Slot new_slot)
+    {
+        const auto mask = slots_.size() - 1;
+        auto position = new_slot.hash & mask;
+        while (slots_[position].entry != 0) {
+            position = (position + 1) & mask;
+        }
+        slots_[position] = new_slot;
+    }
+
+    void rehash(std::size_t slot_count)
+    {
+        slots_.assign(slot_count, Slot {});
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            insertSlot(Slot { hashName(entries_[i].name), static_cast<std::uint32_t>(i + 1) });
+        }
+    }
+
+private:
+    std::vector<Entry> entries_;
+    // size is zero or a power of two
+    std::vector<Slot> slots_;
+};
+} // namespace ppplugin
+
+#endif // PPPLUGIN_PLUGIN_REGISTRY_H
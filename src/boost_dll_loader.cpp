@@ -1,88 +1,184 @@
 #include "ppplugin/detail/boost_dll_loader.h"
 #include "ppplugin/errors.h"
 
+#include <algorithm>
 #include <exception>
 #include <filesystem>
-#include <optional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <utility>
 
+#include <boost/dll/library_info.hpp>
 #include <boost/dll/shared_library.hpp>
 #include <boost/dll/shared_library_load_mode.hpp>
 #include <boost/filesystem/path.hpp>
 
+#if __has_include(<dlfcn.h>)
+#include <dlfcn.h>
+#endif // __has_include
+
 namespace {
-[[nodiscard]] std::optional<ppplugin::CallError> isCallable(const boost::dll::shared_library& library, const std::string& function_name)
+// section used by BOOST_DLL_ALIAS
+constexpr std::string_view ALIAS_SECTION_NAME = "boostdll";
+
+[[nodiscard]] boost::dll::load_mode::type toLoadMode(const ppplugin::detail::boost_dll::LoadOptions& options)
 {
-    if (!library.is_loaded()) {
-        return ppplugin::CallErrorCode::notLoaded;
+    using Binding = ppplugin::detail::boost_dll::LoadOptions::Binding;
+    namespace load_mode = boost::dll::load_mode;
+
+    auto mode = options.binding == Binding::now ? load_mode::rtld_now : load_mode::rtld_lazy;
+    mode |= options.global ? load_mode::rtld_global : load_mode::rtld_local;
+    if (options.deepBind) {
+        mode |= load_mode::rtld_deepbind;
     }
-    // TODO: check ABI compatibility (same compiler + major version)?
-    if (!library.has(function_name)) {
-        return ppplugin::CallErrorCode::symbolNotFound;
+#ifdef RTLD_NODELETE
+    if (options.noDelete) {
+        // not provided by Boost.dll, but passed through to dlopen as-is
+        mode |= static_cast<load_mode::type>(RTLD_NODELETE);
     }
-    // TODO: invalid number of arguments can cause segfault
-    return std::nullopt;
+#endif // RTLD_NODELETE
+    return mode;
 }
 } // namespace
 
 namespace ppplugin::detail::boost_dll {
-CallResult<void*> getFunctionSymbol(const boost::dll::shared_library& library, const std::string& function_name)
+SharedLibrary::SharedLibrary(boost::dll::shared_library library)
+    : library_ { std::move(library) }
 {
-    if (auto error = isCallable(library, function_name)) {
-        return { *error };
+}
+
+CallResult<void*> SharedLibrary::symbolAddress(std::string_view symbol_name) const
+{
+    if (!isLoaded()) {
+        return { CallErrorCode::notLoaded };
+    }
+    {
+        const std::shared_lock lock { symbols_mutex_ };
+        if (auto cached_symbol = symbols_.find(symbol_name); cached_symbol != symbols_.end()) {
+            if (auto* symbol = cached_symbol->second) {
+                return symbol;
+            }
+            return { CallErrorCode::symbolNotFound };
+        }
     }
+
+    // TODO: check ABI compatibility (same compiler + major version)?
+    std::string name { symbol_name };
+    void* symbol = nullptr;
     try {
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        if (auto* symbol = reinterpret_cast<void*>(library.get<void()>(function_name))) {
-            return symbol;
+        // resolve as function to get the plain symbol address; binding a void*
+        // reference to a function address would be undefined behavior
+        if (isIndexed()) {
+            // index is authoritative; avoid additional lookup via library_.has()
+            if (std::binary_search(symbol_index_.begin(), symbol_index_.end(), symbol_name)) {
+                symbol = reinterpret_cast<void*>(library_.get<void()>(name)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            }
+        } else if (library_.has(name)) {
+            symbol = reinterpret_cast<void*>(library_.get<void()>(name)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
         }
     } catch (const std::exception& exception) {
         return CallError { CallErrorCode::unknown, exception.what() };
     }
-    return { CallErrorCode::unknown };
+    // TODO: invalid number of arguments can cause segfault
+
+    const std::unique_lock lock { symbols_mutex_ };
+    symbols_.emplace(std::move(name), symbol);
+    if (symbol == nullptr) {
+        return { CallErrorCode::symbolNotFound };
+    }
+    return symbol;
 }
 
-CallResult<void*> getFunctionPointerSymbol(const boost::dll::shared_library& library, const std::string& function_name)
+bool SharedLibrary::indexSymbols()
 {
-    if (auto error = isCallable(library, function_name)) {
-        return { *error };
+    symbol_index_.clear();
+    if (!isLoaded()) {
+        return false;
     }
     try {
-        if (auto* symbol = library.get<void*>(function_name)) {
-            return symbol;
-        }
-    } catch (const std::exception& exception) {
-        return CallError { CallErrorCode::unknown, exception.what() };
+        boost::dll::library_info info { library_.location() };
+        symbol_index_ = info.symbols();
+    } catch (const std::exception& /*exception*/) {
+        return false;
     }
-    return { CallErrorCode::unknown };
+    std::sort(symbol_index_.begin(), symbol_index_.end());
+    symbol_index_.erase(std::unique(symbol_index_.begin(), symbol_index_.end()), symbol_index_.end());
+    // stripped libraries may not contain a readable symbol table
+    return isIndexed();
 }
 
-CallResult<void**> getSymbol(const boost::dll::shared_library& library, const std::string& function_name)
+bool SharedLibrary::has(std::string_view symbol_name) const
 {
-    if (auto error = isCallable(library, function_name)) {
-        return { *error };
+    if (isIndexed()) {
+        return std::binary_search(symbol_index_.begin(), symbol_index_.end(), symbol_name);
     }
+    return symbolAddress(symbol_name).hasValue();
+}
+
+bool hasAliasSection(const std::filesystem::path& library_path)
+{
     try {
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        if (auto** symbol = &library.get<void*>(function_name)) {
-            return symbol;
-        }
-    } catch (const std::exception& exception) {
-        return CallError { CallErrorCode::unknown, exception.what() };
+        boost::dll::library_info info { boost::dll::fs::path { library_path } };
+        auto sections = info.sections();
+        return std::find(sections.begin(), sections.end(), ALIAS_SECTION_NAME) != sections.end();
+    } catch (const std::exception& /*exception*/) {
+        return false;
+    }
+}
+
+CallResult<void*> getFunctionSymbol(const SharedLibrary* library, std::string_view function_name)
+{
+    if (library == nullptr) {
+        return { CallErrorCode::notLoaded };
     }
-    return { CallErrorCode::unknown };
+    return library->symbolAddress(function_name);
+}
+
+CallResult<void*> getFunctionPointerSymbol(const SharedLibrary* library, std::string_view function_name)
+{
+    return getFunctionSymbol(library, function_name).andThen([](void* symbol) -> CallResult<void*> {
+        // symbol is a variable holding the actual function address
+        if (auto* function = *static_cast<void**>(symbol)) {
+            return function;
+        }
+        return { CallErrorCode::unknown };
+    });
+}
+
+CallResult<void**> getSymbol(const SharedLibrary* library, std::string_view function_name)
+{
+    return getFunctionSymbol(library, function_name).andThen([](void* symbol) {
+        return static_cast<void**>(symbol);
+    });
 }
 
-std::optional<boost::dll::shared_library> loadSharedLibrary(
-    const std::filesystem::path& plugin_library_path)
+Expected<std::shared_ptr<SharedLibrary>, LoadError> loadSharedLibrary(
+    const std::filesystem::path& plugin_library_path, const LoadOptions& options)
 {
     if (!std::filesystem::exists(plugin_library_path)) {
-        return std::nullopt;
+        return LoadError { LoadErrorCode::fileNotFound };
     }
 
-    return boost::dll::shared_library {
-        boost::dll::fs::path { plugin_library_path },
-        boost::dll::load_mode::append_decorations
-    };
+    std::shared_ptr<SharedLibrary> library;
+    try {
+        library = std::make_shared<SharedLibrary>(
+            boost::dll::shared_library {
+                boost::dll::fs::path { plugin_library_path },
+                toLoadMode(options) | boost::dll::load_mode::append_decorations });
+    } catch (const std::exception& exception) {
+        return LoadError { LoadErrorCode::fileInvalid, exception.what() };
+    }
+    if (!library->isLoaded()) {
+        return LoadError { LoadErrorCode::unknown };
+    }
+    if (options.indexSymbols) {
+        // stripped libraries have no symbol table to index; without index,
+        // each symbol is looked up individually via the dynamic linker instead
+        library->indexSymbols();
+    }
+    return library;
 }
 } // namespace ppplugin::detail::boost_dll
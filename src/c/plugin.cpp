@@ -1,21 +1,29 @@
 #include "ppplugin/c/plugin.h"
 
 namespace ppplugin {
-Expected<CPlugin, LoadError> CPlugin::load(const std::filesystem::path& plugin_library_path)
+Expected<CPlugin, LoadError> CPlugin::load(const std::filesystem::path& plugin_library_path, const LoadOptions& options)
 {
-    if (!std::filesystem::exists(plugin_library_path)) {
-        return LoadError { LoadErrorCode::fileNotFound };
-    }
-    if (auto shared_library = detail::boost_dll::loadSharedLibrary(plugin_library_path)) {
-        CPlugin new_plugin;
-        new_plugin.plugin_ = *shared_library;
-        return new_plugin;
-    }
-    return LoadError { LoadErrorCode::unknown };
+    return detail::boost_dll::loadSharedLibrary(plugin_library_path, options)
+        .andThen([](auto&& shared_library) {
+            CPlugin new_plugin;
+            new_plugin.plugin_ = std::forward<decltype(shared_library)>(shared_library);
+            return new_plugin;
+        });
 }
 
 CPlugin::operator bool() const
 {
-    return plugin_.is_loaded();
+    return plugin_ && plugin_->isLoaded();
+}
+
+const std::vector<std::string>& CPlugin::symbols() const
+{
+    static const std::vector<std::string> NO_SYMBOLS;
+    return plugin_ ? plugin_->symbols() : NO_SYMBOLS;
+}
+
+bool CPlugin::has(const std::string& symbol_name) const
+{
+    return plugin_ && plugin_->has(symbol_name);
 }
 } // namespace ppplugin
@@ -0,0 +1,125 @@
+#include "ppplugin/detail/epoch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ppplugin::detail::epoch {
+namespace {
+/**
+ * Release record of exiting thread for reuse by other threads.
+ */
+struct ThreadRecordOwner {
+    ThreadRecordOwner() = default;
+    ~ThreadRecordOwner()
+    {
+        if (record != nullptr) {
+            record->epoch.store(0, std::memory_order_release);
+            record->inUse.store(false, std::memory_order_release);
+        }
+    }
+    ThreadRecordOwner(const ThreadRecordOwner&) = delete;
+    ThreadRecordOwner(ThreadRecordOwner&&) = delete;
+    ThreadRecordOwner& operator=(const ThreadRecordOwner&) = delete;
+    ThreadRecordOwner& operator=(ThreadRecordOwner&&) = delete;
+
+    Domain::Record* record { nullptr };
+};
+} // namespace
+
+Domain::~Domain()
+{
+    // no readers can be left at this point
+    for (auto& retired : retired_) {
+        retired.deleter(retired.object);
+    }
+    auto* record = records_.load(std::memory_order_acquire);
+    while (record != nullptr) {
+        delete std::exchange(record, record->next); // NOLINT(cppcoreguidelines-owning-memory)
+    }
+}
+
+Domain& Domain::global()
+{
+    static Domain domain;
+    return domain;
+}
+
+Domain::Record& Domain::threadRecord()
+{
+    thread_local ThreadRecordOwner owner;
+    if (owner.record == nullptr) {
+        owner.record = acquireRecord();
+    }
+    return *owner.record;
+}
+
+Domain::Record* Domain::acquireRecord()
+{
+    // reuse record of exited thread
+    for (auto* record = records_.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+        bool in_use = false;
+        if (record->inUse.compare_exchange_strong(in_use, true, std::memory_order_acquire)) {
+            record->nesting = 0;
+            return record;
+        }
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-owning-memory); owned by domain
+    auto* record = new Record { { 0 }, { true }, 0, records_.load(std::memory_order_relaxed) };
+    while (!records_.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed)) { }
+    return record;
+}
+
+std::uint64_t Domain::minimumActiveEpoch() const
+{
+    auto minimum_epoch = std::numeric_limits<std::uint64_t>::max();
+    for (auto* record = records_.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+        auto epoch = record->epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0) {
+            minimum_epoch = std::min(minimum_epoch, epoch);
+        }
+    }
+    return minimum_epoch;
+}
+
+void Domain::retire(void* object, Deleter deleter)
+{
+    // readers entering from now on cannot observe the (already unlinked) object
+    auto epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    {
+        const std::lock_guard lock { retired_mutex_ };
+        retired_.push_back(Retired { object, deleter, epoch });
+        // must be visible before scanning readers in collect();
+        // concurrent retire() calls might arrive out of order
+        if (epoch > latest_retired_epoch_.load(std::memory_order_relaxed)) {
+            latest_retired_epoch_.store(epoch, std::memory_order_seq_cst);
+        }
+    }
+    collect();
+}
+
+void Domain::collect()
+{
+    std::vector<Retired> reclaimable;
+    {
+        const std::lock_guard lock { retired_mutex_ };
+        if (retired_.empty()) {
+            return;
+        }
+        auto minimum_epoch = minimumActiveEpoch();
+        auto first_reclaimable = std::stable_partition(retired_.begin(), retired_.end(),
+            [minimum_epoch](const Retired& retired) { return retired.epoch > minimum_epoch; });
+        reclaimable.assign(first_reclaimable, retired_.end());
+        retired_.erase(first_reclaimable, retired_.end());
+    }
+    // destructors may be expensive (e.g. unloading a library); call without lock
+    for (auto& retired : reclaimable) {
+        retired.deleter(retired.object);
+    }
+}
+} // namespace ppplugin::detail::epoch
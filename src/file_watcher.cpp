@@ -0,0 +1,145 @@
+#include "ppplugin/detail/file_watcher.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<sys/inotify.h>)
+#define PPPLUGIN_HAS_INOTIFY
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif // __has_include
+
+namespace ppplugin::detail {
+#ifdef PPPLUGIN_HAS_INOTIFY
+FileWatcher::FileWatcher(Callback callback)
+    : callback_ { std::move(callback) }
+    , inotify_fd_ { inotify_init1(IN_NONBLOCK | IN_CLOEXEC) }
+    , stop_fd_ { eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) }
+{
+    if (inotify_fd_ >= 0 && stop_fd_ >= 0) {
+        thread_ = std::thread { [this]() { run(); } };
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+    if (stop_fd_ >= 0) {
+        close(stop_fd_);
+    }
+}
+
+bool FileWatcher::watch(const std::filesystem::path& file_path)
+{
+    if (!thread_.joinable()) {
+        return false;
+    }
+    std::error_code error;
+    auto absolute_path = std::filesystem::weakly_canonical(file_path, error);
+    if (error) {
+        return false;
+    }
+    // watch parent directory to be notified of files replaced by moving
+    auto directory = absolute_path.parent_path();
+    auto watch_descriptor = inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_descriptor < 0) {
+        return false;
+    }
+
+    const std::lock_guard lock { mutex_ };
+    directories_[watch_descriptor] = std::move(directory);
+    files_.insert(std::move(absolute_path));
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if (thread_.joinable()) {
+        const std::uint64_t value = 1;
+        [[maybe_unused]] auto result = write(stop_fd_, &value, sizeof(value));
+        thread_.join();
+    }
+}
+
+void FileWatcher::run()
+{
+    std::array<pollfd, 2> fds {
+        pollfd { inotify_fd_, POLLIN, 0 },
+        pollfd { stop_fd_, POLLIN, 0 },
+    };
+    alignas(inotify_event) std::array<char, 4096> buffer {};
+
+    while (true) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            return;
+        }
+        if ((fds[0].revents & POLLIN) == 0) {
+            continue;
+        }
+
+        auto length = read(inotify_fd_, buffer.data(), buffer.size());
+        for (decltype(length) offset = 0; offset < length;) {
+            inotify_event event {};
+            std::memcpy(&event, &buffer.at(offset), sizeof(event));
+            const auto* name = &buffer.at(offset + sizeof(inotify_event));
+            offset += static_cast<decltype(length)>(sizeof(inotify_event) + event.len);
+            if (event.len == 0) {
+                continue;
+            }
+
+            std::filesystem::path modified_file;
+            {
+                const std::lock_guard lock { mutex_ };
+                auto directory = directories_.find(event.wd);
+                if (directory == directories_.end()) {
+                    continue;
+                }
+                modified_file = directory->second / name;
+                if (files_.count(modified_file) == 0) {
+                    continue;
+                }
+            }
+            try {
+                callback_(modified_file);
+            } catch (const std::exception& /*exception*/) {
+                // keep watching other files
+            }
+        }
+    }
+}
+#else
+FileWatcher::FileWatcher(Callback callback)
+    : callback_ { std::move(callback) }
+{
+}
+
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::watch(const std::filesystem::path& /*file_path*/)
+{
+    return false;
+}
+
+void FileWatcher::stop() { }
+
+void FileWatcher::run() { }
+#endif // PPPLUGIN_HAS_INOTIFY
+} // namespace ppplugin::detail
@@ -0,0 +1,142 @@
+#include "ppplugin/lua/lua_allocator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace ppplugin {
+void* LuaAllocator::reallocate(void* block, std::size_t old_size, std::size_t new_size)
+{
+    // Lua passes the object type instead of the size for new blocks
+    if (block == nullptr) {
+        old_size = 0;
+    }
+    if (new_size == 0) {
+        if (block != nullptr) {
+            deallocate(block, old_size);
+            memory_usage_ -= old_size;
+        }
+        return nullptr;
+    }
+    // never fail shrinking, only growing beyond limit
+    if (new_size > old_size && new_size - old_size > memory_limit_ - std::min(memory_usage_, memory_limit_)) {
+        return nullptr;
+    }
+    auto* new_block = block == nullptr ? allocate(new_size) : resize(block, old_size, new_size);
+    if (new_block == nullptr && new_size <= old_size) {
+        // resize() might move the block (e.g. into a smaller size class) which can
+        // fail, but Lua 5.2, 5.3 and LuaJIT rely on shrinking to succeed;
+        // the original block is large enough and will be freed with the new size
+        new_block = block;
+    }
+    if (new_block != nullptr) {
+        memory_usage_ = memory_usage_ - old_size + new_size;
+    }
+    return new_block;
+}
+
+void* LuaAllocator::resize(void* block, std::size_t old_size, std::size_t new_size)
+{
+    auto* new_block = allocate(new_size);
+    if (new_block != nullptr) {
+        std::memcpy(new_block, block, std::min(old_size, new_size));
+        deallocate(block, old_size);
+    }
+    return new_block;
+}
+
+LuaPoolAllocator::~LuaPoolAllocator()
+{
+    while (chunks_ != nullptr) {
+        auto* previous_chunk = *static_cast<void**>(chunks_);
+        std::free(chunks_); // NOLINT(cppcoreguidelines-no-malloc)
+        chunks_ = previous_chunk;
+    }
+}
+
+void* LuaPoolAllocator::allocate(std::size_t size)
+{
+    if (size > MAXIMUM_POOLED_SIZE) {
+        return std::malloc(size); // NOLINT(cppcoreguidelines-no-malloc)
+    }
+    auto size_class = sizeClass(size);
+    if (auto* free_block = free_blocks_[size_class]) {
+        free_blocks_[size_class] = free_block->next;
+        return free_block;
+    }
+    const auto block_size = (size_class + 1) * SIZE_CLASS_GRANULARITY;
+    if (chunk_used_ + block_size > CHUNK_SIZE) {
+        // remainder of previous chunk is left unused
+        auto* chunk = allocateChunk(CHUNK_SIZE);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        *static_cast<void**>(chunk) = chunks_;
+        chunks_ = chunk;
+        // keep blocks aligned to size class granularity
+        chunk_used_ = SIZE_CLASS_GRANULARITY;
+    }
+    auto* block = static_cast<std::byte*>(chunks_) + chunk_used_;
+    chunk_used_ += block_size;
+    return block;
+}
+
+void LuaPoolAllocator::deallocate(void* block, std::size_t size)
+{
+    if (size > MAXIMUM_POOLED_SIZE) {
+        std::free(block); // NOLINT(cppcoreguidelines-no-malloc)
+        return;
+    }
+    // rare case of shrinking failure; the chunks are only searched if necessary
+    if (foreign_block_count_ > 0 && !isPooled(block)) {
+        --foreign_block_count_;
+        std::free(block); // NOLINT(cppcoreguidelines-no-malloc)
+        return;
+    }
+    auto size_class = sizeClass(size);
+    free_blocks_[size_class] = new (block) FreeBlock { free_blocks_[size_class] };
+}
+
+void* LuaPoolAllocator::resize(void* block, std::size_t old_size, std::size_t new_size)
+{
+    if (old_size > MAXIMUM_POOLED_SIZE && new_size > MAXIMUM_POOLED_SIZE) {
+        return std::realloc(block, new_size); // NOLINT(cppcoreguidelines-no-malloc)
+    }
+    if (old_size > MAXIMUM_POOLED_SIZE && new_size <= MAXIMUM_POOLED_SIZE) {
+        auto* new_block = allocate(new_size);
+        if (new_block == nullptr) {
+            // malloc'd block is kept and will be deallocated with pooled size
+            ++foreign_block_count_;
+            return nullptr;
+        }
+        std::memcpy(new_block, block, new_size);
+        std::free(block); // NOLINT(cppcoreguidelines-no-malloc)
+        return new_block;
+    }
+    if (old_size <= MAXIMUM_POOLED_SIZE && new_size <= MAXIMUM_POOLED_SIZE
+        && sizeClass(old_size) == sizeClass(new_size)) {
+        return block;
+    }
+    return LuaAllocator::resize(block, old_size, new_size);
+}
+
+void* LuaPoolAllocator::allocateChunk(std::size_t size)
+{
+    return std::malloc(size); // NOLINT(cppcoreguidelines-no-malloc)
+}
+
+bool LuaPoolAllocator::isPooled(const void* block) const
+{
+    const std::less<const void*> less;
+    for (const void* chunk = chunks_; chunk != nullptr; chunk = *static_cast<void* const*>(chunk)) {
+        const void* chunk_end = static_cast<const std::byte*>(chunk) + CHUNK_SIZE;
+        if (!less(block, chunk) && less(block, chunk_end)) {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace ppplugin
@@ -0,0 +1,118 @@
+#ifndef PPPLUGIN_LUA_COMPATIBILITY_H
+#define PPPLUGIN_LUA_COMPATIBILITY_H
+
+// Lua headers and shims for differences between the supported C APIs
+// (Lua 5.2 to 5.4 and LuaJIT which implements the Lua 5.1 API).
+// Private to the Lua sources, Lua is not part of the public interface.
+
+extern "C" {
+#include <lauxlib.h>
+#include <lua.h>
+#include <lualib.h>
+#ifdef PPPLUGIN_LUA_BACKEND_LUAJIT
+#include <luajit.h>
+#endif // PPPLUGIN_LUA_BACKEND_LUAJIT
+}
+
+#if LUA_VERSION_NUM < 502
+#ifndef LUA_OK
+#define LUA_OK 0
+#endif // LUA_OK
+#define lua_rawlen lua_objlen
+#endif // LUA_VERSION_NUM
+
+namespace ppplugin::detail::lua {
+/**
+ * Dump function on top of the stack as bytecode including debug information.
+ */
+inline int dump(lua_State* state, lua_Writer writer, void* data)
+{
+#if LUA_VERSION_NUM >= 503
+    return lua_dump(state, writer, data, 0);
+#else
+    return lua_dump(state, writer, data);
+#endif // LUA_VERSION_NUM
+}
+
+/**
+ * Version of the bytecode format written by dump().
+ */
+constexpr int bytecodeVersion()
+{
+#ifdef LUAJIT_VERSION_NUM
+    return LUAJIT_VERSION_NUM;
+#else
+    return LUA_VERSION_NUM;
+#endif // LUAJIT_VERSION_NUM
+}
+
+/**
+ * Start or continue coroutine; results or yielded values are on top of its stack.
+ */
+inline int resume(lua_State* thread, int argument_count, int& result_count)
+{
+#if LUA_VERSION_NUM >= 504
+    return lua_resume(thread, nullptr, argument_count, &result_count);
+#else
+#if LUA_VERSION_NUM >= 502
+    auto status = lua_resume(thread, nullptr, argument_count);
+#else
+    auto status = lua_resume(thread, argument_count);
+#endif // LUA_VERSION_NUM
+    // stack of coroutine contains nothing but results or yielded values
+    result_count = lua_gettop(thread);
+    return status;
+#endif // LUA_VERSION_NUM
+}
+
+/**
+ * Switch to incremental garbage collection; zero keeps the respective parameter.
+ */
+inline void setIncrementalGc(lua_State* state, int pause, int step_multiplier)
+{
+#if LUA_VERSION_NUM >= 504
+    lua_gc(state, LUA_GCINC, pause, step_multiplier, 0);
+#else
+#ifdef LUA_GCINC
+    lua_gc(state, LUA_GCINC, 0);
+#endif // LUA_GCINC
+    if (pause != 0) {
+        lua_gc(state, LUA_GCSETPAUSE, pause);
+    }
+    if (step_multiplier != 0) {
+        lua_gc(state, LUA_GCSETSTEPMUL, step_multiplier);
+    }
+#endif // LUA_VERSION_NUM
+}
+
+/**
+ * Switch to generational garbage collection with default parameters.
+ *
+ * @return false if not supported (Lua 5.3 and LuaJIT)
+ */
+inline bool setGenerationalGc([[maybe_unused]] lua_State* state)
+{
+#if LUA_VERSION_NUM >= 504
+    lua_gc(state, LUA_GCGEN, 0, 0);
+    return true;
+#elif defined(LUA_GCGEN)
+    lua_gc(state, LUA_GCGEN, 0);
+    return true;
+#else
+    return false;
+#endif // LUA_VERSION_NUM
+}
+
+/**
+ * Enable or disable JIT compilation; compiled code does not run hooks
+ * which are needed to enforce execution limits. No-op for other backends.
+ */
+inline void setJitEnabled([[maybe_unused]] lua_State* state, [[maybe_unused]] bool enabled)
+{
+#ifdef PPPLUGIN_LUA_BACKEND_LUAJIT
+    luaJIT_setmode(state, 0, LUAJIT_MODE_ENGINE | (enabled ? LUAJIT_MODE_ON : LUAJIT_MODE_OFF));
+#endif // PPPLUGIN_LUA_BACKEND_LUAJIT
+}
+} // namespace ppplugin::detail::lua
+
+#endif // PPPLUGIN_LUA_COMPATIBILITY_H
@@ -4,30 +4,280 @@
 #include "ppplugin/expected.h"
 #include "ppplugin/lua/lua_state.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
 
-extern "C" {
-#include <lauxlib.h>
-#include <lua.h>
-#include <lualib.h>
+#if __has_include(<sys/mman.h>)
+#define PPPLUGIN_HAS_MMAN
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // __has_include
+
+#include "lua_compatibility.h"
+
+namespace {
+/**
+ * Header of bytecode cache file; the bytecode follows directly after it.
+ */
+struct CacheHeader {
+    std::array<char, 4> magic;
+    std::uint32_t luaVersion;
+    std::uint64_t sourceSize;
+    std::int64_t sourceModificationTime;
+    std::uint64_t sourceHash;
+};
+constexpr std::array<char, 4> CACHE_MAGIC { 'P', 'P', 'L', 'C' };
+
+/**
+ * 64 bit FNV-1a hash; unlike std::hash, stable across processes.
+ */
+std::uint64_t hashBytes(std::string_view bytes)
+{
+    constexpr std::uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr std::uint64_t PRIME = 1099511628211ULL;
+    auto hash = OFFSET_BASIS;
+    for (auto byte : bytes) {
+        hash = (hash ^ static_cast<unsigned char>(byte)) * PRIME;
+    }
+    return hash;
+}
+
+std::optional<std::string> readFile(const std::filesystem::path& path)
+{
+    std::ifstream file { path, std::ios::binary };
+    if (!file) {
+        return std::nullopt;
+    }
+    std::string content { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+    if (file.bad()) {
+        return std::nullopt;
+    }
+    return content;
+}
+
+#ifdef PPPLUGIN_HAS_MMAN
+/**
+ * Check that file is a regular file of the current user which cannot be
+ * modified by other users, i.e. its content can be trusted.
+ */
+bool isTrustedFile(const struct stat& file_status)
+{
+    return S_ISREG(file_status.st_mode) && file_status.st_uid == geteuid()
+        && (file_status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+#endif // PPPLUGIN_HAS_MMAN
+
+/**
+ * Read-only view of a whole trusted file (see isTrustedFile());
+ * memory mapped if supported.
+ * Empty if the file could not be read or is not trusted.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path)
+    {
+#ifdef PPPLUGIN_HAS_MMAN
+        auto file_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT(cppcoreguidelines-pro-type-vararg)
+        if (file_descriptor < 0) {
+            return;
+        }
+        struct stat file_status { };
+        // check opened file to avoid race with replacement of the file
+        if (fstat(file_descriptor, &file_status) == 0 && isTrustedFile(file_status) && file_status.st_size > 0) {
+            auto size = static_cast<std::size_t>(file_status.st_size);
+            auto* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            if (data != MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                data_ = data;
+                size_ = size;
+            }
+        }
+        close(file_descriptor);
+#else
+        content_ = readFile(path).value_or("");
+#endif // PPPLUGIN_HAS_MMAN
+    }
+
+    ~MappedFile()
+    {
+#ifdef PPPLUGIN_HAS_MMAN
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+#endif // PPPLUGIN_HAS_MMAN
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    [[nodiscard]] std::string_view content() const
+    {
+#ifdef PPPLUGIN_HAS_MMAN
+        return { static_cast<const char*>(data_), size_ };
+#else
+        return content_;
+#endif // PPPLUGIN_HAS_MMAN
+    }
+
+private:
+#ifdef PPPLUGIN_HAS_MMAN
+    void* data_ {};
+    std::size_t size_ {};
+#else
+    std::string content_;
+#endif // PPPLUGIN_HAS_MMAN
+};
+
+/**
+ * Return bytecode stored in cache file if it was created from the given source.
+ */
+std::optional<std::string_view> cachedBytecode(std::string_view cache_content, const CacheHeader& expected_header)
+{
+    if (cache_content.size() <= sizeof(CacheHeader)) {
+        return std::nullopt;
+    }
+    CacheHeader header {};
+    std::memcpy(&header, cache_content.data(), sizeof(CacheHeader));
+    if (header.magic != expected_header.magic || header.luaVersion != expected_header.luaVersion
+        || header.sourceSize != expected_header.sourceSize
+        || header.sourceModificationTime != expected_header.sourceModificationTime
+        || header.sourceHash != expected_header.sourceHash) {
+        return std::nullopt;
+    }
+    return cache_content.substr(sizeof(CacheHeader));
 }
 
+/**
+ * Write function on top of the stack to the cache file.
+ * Write to temporary file first, so that concurrent loads never see partial files.
+ * Errors are ignored since the cache is optional.
+ */
+void storeBytecode(lua_State* state, const std::filesystem::path& cache_file, const CacheHeader& header)
+{
+    std::string content(sizeof(CacheHeader), '\0');
+    std::memcpy(content.data(), &header, sizeof(CacheHeader));
+    auto writer = [](lua_State* /*state*/, const void* data, std::size_t size, void* output) -> int {
+        static_cast<std::string*>(output)->append(static_cast<const char*>(data), size);
+        return 0;
+    };
+    // keep debug information for meaningful error messages
+    if (ppplugin::detail::lua::dump(state, writer, &content) != 0) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(cache_file.parent_path(), error);
+    auto temporary_file = cache_file;
+    temporary_file += ppplugin::format(".{:x}.tmp", hashBytes(content));
+    {
+        std::ofstream file { temporary_file, std::ios::binary | std::ios::trunc };
+        if (!file.write(content.data(), static_cast<std::streamsize>(content.size()))) {
+            file.close();
+            std::filesystem::remove(temporary_file, error);
+            return;
+        }
+    }
+    // cache files writable by others are not trusted, independent of umask
+    std::filesystem::permissions(temporary_file,
+        std::filesystem::perms::owner_read | std::filesystem::perms::owner_write
+            | std::filesystem::perms::group_read | std::filesystem::perms::others_read,
+        error);
+    std::filesystem::rename(temporary_file, cache_file, error);
+    if (error) {
+        std::filesystem::remove(temporary_file, error);
+    }
+}
+} // namespace
+
 namespace ppplugin {
 Expected<LuaScript, LoadError> LuaScript::load(const std::filesystem::path& script_path, bool auto_run)
 {
-    LuaScript new_script;
-    if (auto error = new_script.loadFile(script_path, auto_run)) {
+    LoadOptions options;
+    options.autoRun = auto_run;
+    return load(script_path, options);
+}
+
+Expected<LuaScript, LoadError> LuaScript::load(const std::filesystem::path& script_path, const LoadOptions& options)
+{
+    auto new_script = create(options);
+    if (!new_script) {
+        return new_script.error();
+    }
+    auto error = options.bytecodeCacheDirectory.empty()
+        ? new_script->loadFile(script_path, options.autoRun)
+        : new_script->loadCachedFile(script_path, options.bytecodeCacheDirectory, options.autoRun);
+    if (error) {
         return *error;
     }
     return new_script;
 }
 
-LuaScript::LuaScript()
+Expected<std::string, LoadError> LuaScript::compile(const std::filesystem::path& script_path)
+{
+    if (!std::filesystem::exists(script_path)) {
+        return LoadError { LoadErrorCode::fileNotFound };
+    }
+    LuaState state;
+    if (luaL_loadfile(state.state(), script_path.c_str()) != LUA_OK) {
+        return LoadError { LoadErrorCode::fileInvalid };
+    }
+    std::string bytecode;
+    auto writer = [](lua_State* /*state*/, const void* data, std::size_t size, void* output) -> int {
+        static_cast<std::string*>(output)->append(static_cast<const char*>(data), size);
+        return 0;
+    };
+    // keep debug information for meaningful error messages
+    if (detail::lua::dump(state.state(), writer, &bytecode) != 0) {
+        return LoadError { LoadErrorCode::unknown, "Unable to dump bytecode" };
+    }
+    return bytecode;
+}
+
+Expected<LuaScript, LoadError> LuaScript::loadFromBuffer(
+    std::string_view source_or_bytecode, const std::string& chunk_name, bool auto_run)
+{
+    LoadOptions options;
+    options.autoRun = auto_run;
+    return loadFromBuffer(source_or_bytecode, chunk_name, options);
+}
+
+Expected<LuaScript, LoadError> LuaScript::loadFromBuffer(
+    std::string_view source_or_bytecode, const std::string& chunk_name, const LoadOptions& options)
+{
+    auto new_script = create(options);
+    if (!new_script) {
+        return new_script.error();
+    }
+    if (luaL_loadbufferx(new_script->state_.state(), source_or_bytecode.data(), source_or_bytecode.size(),
+            chunk_name.c_str(), "bt")
+        != LUA_OK) {
+        return LoadError { LoadErrorCode::fileInvalid };
+    }
+    if (options.autoRun && !new_script->run()) {
+        return LoadError { LoadErrorCode::unknown };
+    }
+    return new_script;
+}
+
+LuaScript::LuaScript(std::unique_ptr<LuaAllocator> allocator)
+    : state_ { std::move(allocator) }
 {
-    luaL_openlibs(state_.state());
+    if (state_.state() == nullptr) {
+        return;
+    }
     state_.registerPanicHandler([](lua_State* state) -> int {
         auto error = LuaState::wrap(state).top<std::string>();
         // TODO: don't throw because will cross library boundaries
@@ -36,6 +286,31 @@ LuaScript::LuaScript()
     // TODO: setup lua_setwarnf
 }
 
+Expected<LuaScript, LoadError> LuaScript::create(const LoadOptions& options)
+{
+    LuaScript new_script { options.allocator ? options.allocator() : nullptr };
+    auto* state = new_script.state_.state();
+    if (state == nullptr) {
+        return LoadError { LoadErrorCode::unknown, "Unable to create Lua state" };
+    }
+    // open libraries in protected mode since allocations might fail
+    lua_pushcfunction(state, [](lua_State* state) -> int {
+        luaL_openlibs(state);
+        return 0;
+    });
+    if (lua_pcall(state, 0, 0, 0) != LUA_OK) {
+        return LoadError { LoadErrorCode::unknown, "Unable to open Lua standard libraries" };
+    }
+    if (!new_script.state_.setGarbageCollectorOptions(options.garbageCollector)) {
+        return LoadError { LoadErrorCode::unknown, "Garbage collector mode not supported by Lua version" };
+    }
+    new_script.setExecutionLimits(options.executionLimits);
+    for (const auto& [name, table] : options.sharedGlobals) {
+        new_script.global(name, table);
+    }
+    return new_script;
+}
+
 bool LuaScript::run()
 {
     return lua_pcall(state_.state(), 0, LUA_MULTRET, 0) == LUA_OK;
@@ -55,6 +330,74 @@ std::optional<LoadError> LuaScript::loadFile(const std::filesystem::path& lua_fi
     return std::nullopt;
 }
 
+std::optional<LoadError> LuaScript::loadCachedFile(const std::filesystem::path& lua_file,
+    const std::filesystem::path& cache_directory, bool auto_run)
+{
+    std::error_code error;
+    auto modification_time = std::filesystem::last_write_time(lua_file, error);
+    if (error) {
+        return LoadError { LoadErrorCode::fileNotFound };
+    }
+    auto source = readFile(lua_file);
+    if (!source) {
+        return LoadError { LoadErrorCode::fileNotReadable };
+    }
+    const CacheHeader header {
+        CACHE_MAGIC,
+        static_cast<std::uint32_t>(detail::lua::bytecodeVersion()),
+        source->size(),
+        static_cast<std::int64_t>(modification_time.time_since_epoch().count()),
+        hashBytes(*source),
+    };
+    auto absolute_path = std::filesystem::weakly_canonical(lua_file, error);
+    if (error) {
+        absolute_path = std::filesystem::absolute(lua_file);
+    }
+    auto cache_file = cache_directory / format("{:016x}.luac", hashBytes(absolute_path.string()));
+    // same chunk name as luaL_loadfile for identical error messages
+    auto chunk_name = "@" + lua_file.string();
+
+    bool is_loaded = false;
+    {
+        const MappedFile cache_content { cache_file };
+        if (auto bytecode = cachedBytecode(cache_content.content(), header)) {
+            is_loaded = luaL_loadbufferx(state_.state(), bytecode->data(), bytecode->size(), chunk_name.c_str(), "b") == LUA_OK;
+            if (!is_loaded) {
+                // corrupt cache file; pop error message and compile again
+                state_.discardTop();
+            }
+        }
+    }
+    if (!is_loaded) {
+        std::string_view code { *source };
+        // skip first line starting with '#' (e.g. shebang) like luaL_loadfile, but keep line numbers
+        if (!code.empty() && code.front() == '#') {
+            auto line_end = code.find('\n');
+            code = line_end == std::string_view::npos ? std::string_view {} : code.substr(line_end);
+        }
+        if (luaL_loadbufferx(state_.state(), code.data(), code.size(), chunk_name.c_str(), nullptr) != LUA_OK) {
+            return LoadError { LoadErrorCode::fileInvalid };
+        }
+        storeBytecode(state_.state(), cache_file, header);
+    }
+    if (auto_run && !run()) {
+        return LoadError { LoadErrorCode::unknown };
+    }
+    return std::nullopt;
+}
+
+CallResult<LuaFunctionHandle> LuaScript::function(const std::string& function_name)
+{
+    if (!state_.pushGlobal(function_name)) {
+        return { CallErrorCode::symbolNotFound };
+    }
+    if (!state_.isFunction()) {
+        state_.discardTop();
+        return { CallErrorCode::incorrectType };
+    }
+    return LuaFunctionHandle { state_.state(), state_.storeInRegistry() };
+}
+
 std::string LuaScript::errorToString(int error_code)
 {
     switch (error_code) {
@@ -1,21 +1,375 @@
 #include "ppplugin/lua/lua_state.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
 #include <optional>
 #include <ostream>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
-extern "C" {
-#include <lauxlib.h>
-#include <lua.h>
-}
+#include "lua_compatibility.h"
 
 // TODO: move to cmake?
 namespace {
 constexpr auto MINIMUM_LUA_VERSION = 502;
+// addresses of the following serve as registry keys; unlike strings, pushing
+// light userdata never allocates, thus lookups cannot fail after memory errors
+// registry field of table anchoring strings retrieved as std::string_view
+constexpr char RESULT_ANCHOR_KEY {};
+// registry field of userdata holding ExecutionBudget
+constexpr char EXECUTION_BUDGET_KEY {};
+// maximum number of instructions between checks of execution limits
+constexpr std::uint64_t EXECUTION_HOOK_INTERVAL = 1000;
+
+struct ExecutionBudget {
+    ppplugin::LuaExecutionLimits limits;
+    int hookInterval;
+    std::uint64_t executedInstructions;
+    std::chrono::steady_clock::time_point deadline;
+    bool isExceeded;
+};
+
+void pushRegistryKey(lua_State* state, const char& key)
+{
+    // Lua never writes through light userdata
+    lua_pushlightuserdata(state, const_cast<char*>(&key)); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+}
+
+void getRegistryField(lua_State* state, const char& key)
+{
+    pushRegistryKey(state, key);
+    lua_rawget(state, LUA_REGISTRYINDEX);
+}
+
+/**
+ * Pop value from stack and store it in registry field.
+ */
+void setRegistryField(lua_State* state, const char& key)
+{
+    pushRegistryKey(state, key);
+    lua_insert(state, -2);
+    lua_rawset(state, LUA_REGISTRYINDEX);
+}
+
+ExecutionBudget* executionBudget(lua_State* state)
+{
+    getRegistryField(state, EXECUTION_BUDGET_KEY);
+    auto* budget = static_cast<ExecutionBudget*>(lua_touserdata(state, -1));
+    lua_pop(state, 1);
+    return budget;
+}
+
+void executionLimitHook(lua_State* state, lua_Debug* /*debug*/)
+{
+    auto* budget = executionBudget(state);
+    if (budget == nullptr) {
+        return;
+    }
+    budget->executedInstructions += static_cast<std::uint64_t>(budget->hookInterval);
+    const auto& limits = budget->limits;
+    if ((limits.instructionLimit != 0 && budget->executedInstructions >= limits.instructionLimit)
+        || (limits.timeLimit.count() != 0 && std::chrono::steady_clock::now() >= budget->deadline)) {
+        budget->isExceeded = true;
+        luaL_error(state, "execution limit exceeded");
+    }
+}
+
+/**
+ * Start new budget for the following call if execution limits are set.
+ */
+void resetExecutionBudget(lua_State* state)
+{
+    if (lua_gethook(state) != &executionLimitHook) {
+        return;
+    }
+    if (auto* budget = executionBudget(state)) {
+        budget->executedInstructions = 0;
+        budget->deadline = std::chrono::steady_clock::now() + budget->limits.timeLimit;
+        budget->isExceeded = false;
+        // restart instruction count of hook
+        lua_sethook(state, &executionLimitHook, LUA_MASKCOUNT, budget->hookInterval);
+    }
+}
+
+// name of metatable of userdata created for LuaBuffer
+constexpr auto BUFFER_METATABLE = "ppplugin.LuaBuffer";
+
+using ppplugin::detail::lua::BufferElementType;
+using ppplugin::detail::lua::BufferView;
+
+/**
+ * Call given function with a value of the C++ type corresponding to given element type.
+ */
+template <typename Function>
+void visitElementType(BufferElementType type, Function&& function)
+{
+    switch (type) {
+    case BufferElementType::int8:
+        return function(std::int8_t {});
+    case BufferElementType::uint8:
+        return function(std::uint8_t {});
+    case BufferElementType::int16:
+        return function(std::int16_t {});
+    case BufferElementType::uint16:
+        return function(std::uint16_t {});
+    case BufferElementType::int32:
+        return function(std::int32_t {});
+    case BufferElementType::uint32:
+        return function(std::uint32_t {});
+    case BufferElementType::int64:
+        return function(std::int64_t {});
+    case BufferElementType::uint64:
+        return function(std::uint64_t {});
+    case BufferElementType::float32:
+        return function(float {});
+    case BufferElementType::float64:
+        return function(double {});
+    }
+}
+
+/**
+ * Get zero-based index from Lua index at given stack position
+ * or std::nullopt if it is out of range.
+ */
+std::optional<std::size_t> bufferIndex(lua_State* state, const BufferView& buffer, int stack_index)
+{
+    int is_integer = 0;
+    auto index = lua_tointegerx(state, stack_index, &is_integer);
+    if (is_integer == 0 || index < 1 || static_cast<std::size_t>(index) > buffer.size) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(index - 1);
+}
+
+int bufferGet(lua_State* state)
+{
+    const auto& buffer = *static_cast<BufferView*>(luaL_checkudata(state, 1, BUFFER_METATABLE));
+    auto index = bufferIndex(state, buffer, 2);
+    if (!index) {
+        lua_pushnil(state);
+        return 1;
+    }
+    visitElementType(buffer.type, [state, &buffer, index](auto type) {
+        using T = decltype(type);
+        auto value = static_cast<const T*>(buffer.data)[*index];
+        if constexpr (std::is_floating_point_v<T>) {
+            lua_pushnumber(state, static_cast<lua_Number>(value));
+        } else {
+            lua_pushinteger(state, static_cast<lua_Integer>(value));
+        }
+    });
+    return 1;
+}
+
+int bufferSet(lua_State* state)
+{
+    const auto& buffer = *static_cast<BufferView*>(luaL_checkudata(state, 1, BUFFER_METATABLE));
+    auto index = bufferIndex(state, buffer, 2);
+    if (!index) {
+        return luaL_error(state, "buffer index out of range");
+    }
+    const bool is_floating_point = buffer.type == BufferElementType::float32 || buffer.type == BufferElementType::float64;
+    // check before visiting since luaL_check* functions do not return on error
+    const auto number = is_floating_point ? luaL_checknumber(state, 3) : lua_Number {};
+    const auto integer = is_floating_point ? lua_Integer {} : luaL_checkinteger(state, 3);
+    visitElementType(buffer.type, [&buffer, index, number, integer](auto type) {
+        using T = decltype(type);
+        if constexpr (std::is_floating_point_v<T>) {
+            static_cast<T*>(buffer.data)[*index] = static_cast<T>(number);
+        } else {
+            static_cast<T*>(buffer.data)[*index] = static_cast<T>(integer);
+        }
+    });
+    return 0;
+}
+
+int bufferLength(lua_State* state)
+{
+    const auto& buffer = *static_cast<BufferView*>(luaL_checkudata(state, 1, BUFFER_METATABLE));
+    lua_pushinteger(state, static_cast<lua_Integer>(buffer.size));
+    return 1;
+}
+
+int bufferDestroy(lua_State* state)
+{
+    static_cast<BufferView*>(luaL_checkudata(state, 1, BUFFER_METATABLE))->~BufferView();
+    return 0;
+}
+
+// name of metatable of userdata created for LuaSharedTable
+constexpr auto SHARED_TABLE_METATABLE = "ppplugin.LuaSharedTable";
+
+using ppplugin::LuaSharedTable;
+
+void pushSharedTable(lua_State* state, const LuaSharedTable& table);
+
+void pushSharedTableValue(lua_State* state, const LuaSharedTable::Value& value)
+{
+    std::visit([state](const auto& alternative) {
+        using T = std::decay_t<decltype(alternative)>;
+        if constexpr (std::is_same_v<T, bool>) {
+            lua_pushboolean(state, alternative ? 1 : 0);
+        } else if constexpr (std::is_same_v<T, std::int64_t>) {
+            lua_pushinteger(state, static_cast<lua_Integer>(alternative));
+        } else if constexpr (std::is_same_v<T, double>) {
+            lua_pushnumber(state, static_cast<lua_Number>(alternative));
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            lua_pushlstring(state, alternative.data(), alternative.size());
+        } else {
+            pushSharedTable(state, alternative);
+        }
+    },
+        value);
+}
+
+/**
+ * Get zero-based index into array part from key at given stack position
+ * or std::nullopt if it is not an integer in range.
+ */
+std::optional<std::size_t> sharedTableIndex(lua_State* state, const LuaSharedTable& table, int stack_index)
+{
+    if (lua_type(state, stack_index) != LUA_TNUMBER) {
+        return std::nullopt;
+    }
+    int is_integer = 0;
+    auto index = lua_tointegerx(state, stack_index, &is_integer);
+    if (is_integer == 0 || index < 1 || static_cast<std::size_t>(index) > table.array().size()) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(index - 1);
+}
+
+std::string_view stringAt(lua_State* state, int stack_index)
+{
+    std::size_t length {};
+    const auto* string = lua_tolstring(state, stack_index, &length);
+    return { string, length };
+}
+
+int sharedTableGet(lua_State* state)
+{
+    const auto& table = *static_cast<LuaSharedTable*>(luaL_checkudata(state, 1, SHARED_TABLE_METATABLE));
+    if (auto index = sharedTableIndex(state, table, 2)) {
+        pushSharedTableValue(state, table.array()[*index]);
+        return 1;
+    }
+    if (lua_type(state, 2) == LUA_TSTRING) {
+        if (auto field = table.fields().find(stringAt(state, 2)); field != table.fields().end()) {
+            pushSharedTableValue(state, field->second);
+            return 1;
+        }
+    }
+    lua_pushnil(state);
+    return 1;
+}
+
+int sharedTableSet(lua_State* state)
+{
+    return luaL_error(state, "attempt to modify read-only shared table");
+}
+
+int sharedTableLength(lua_State* state)
+{
+    const auto& table = *static_cast<LuaSharedTable*>(luaL_checkudata(state, 1, SHARED_TABLE_METATABLE));
+    lua_pushinteger(state, static_cast<lua_Integer>(table.array().size()));
+    return 1;
+}
+
+/**
+ * Same as Lua's next() for shared tables: array part first, then fields.
+ */
+int sharedTableNext(lua_State* state)
+{
+    const auto& table = *static_cast<LuaSharedTable*>(luaL_checkudata(state, 1, SHARED_TABLE_METATABLE));
+    lua_settop(state, 2);
+    auto field = table.fields().begin();
+    if (lua_type(state, 2) == LUA_TSTRING) {
+        field = table.fields().upper_bound(stringAt(state, 2));
+    } else {
+        const auto next_index = lua_isnil(state, 2) ? 0 : sharedTableIndex(state, table, 2).value_or(table.array().size()) + 1;
+        if (next_index < table.array().size()) {
+            lua_pushinteger(state, static_cast<lua_Integer>(next_index + 1));
+            pushSharedTableValue(state, table.array()[next_index]);
+            return 2;
+        }
+    }
+    if (field == table.fields().end()) {
+        lua_pushnil(state);
+        return 1;
+    }
+    lua_pushlstring(state, field->first.data(), field->first.size());
+    pushSharedTableValue(state, field->second);
+    return 2;
+}
+
+int sharedTablePairs(lua_State* state)
+{
+    luaL_checkudata(state, 1, SHARED_TABLE_METATABLE);
+    lua_pushcfunction(state, &sharedTableNext);
+    lua_pushvalue(state, 1);
+    lua_pushnil(state);
+    return 3;
+}
+
+#if LUA_VERSION_NUM < 502
+/**
+ * pairs() respecting __pairs like Lua 5.2; original pairs is upvalue 1.
+ */
+int pairsWithMetamethod(lua_State* state)
+{
+    if (luaL_getmetafield(state, 1, "__pairs") != 0) {
+        lua_pushvalue(state, 1);
+        lua_call(state, 1, 3);
+        return 3;
+    }
+    lua_pushvalue(state, lua_upvalueindex(1));
+    lua_insert(state, 1);
+    lua_call(state, lua_gettop(state) - 1, 3);
+    return 3;
+}
+#endif // LUA_VERSION_NUM
+
+int sharedTableDestroy(lua_State* state)
+{
+    static_cast<LuaSharedTable*>(luaL_checkudata(state, 1, SHARED_TABLE_METATABLE))->~LuaSharedTable();
+    return 0;
+}
+
+void pushSharedTable(lua_State* state, const LuaSharedTable& table)
+{
+    new (lua_newuserdata(state, sizeof(LuaSharedTable))) LuaSharedTable { table };
+    if (luaL_newmetatable(state, SHARED_TABLE_METATABLE) != 0) {
+        lua_pushcfunction(state, &sharedTableGet);
+        lua_setfield(state, -2, "__index");
+        lua_pushcfunction(state, &sharedTableSet);
+        lua_setfield(state, -2, "__newindex");
+        lua_pushcfunction(state, &sharedTableLength);
+        lua_setfield(state, -2, "__len");
+        lua_pushcfunction(state, &sharedTablePairs);
+        lua_setfield(state, -2, "__pairs");
+        lua_pushcfunction(state, &sharedTableDestroy);
+        lua_setfield(state, -2, "__gc");
+#if LUA_VERSION_NUM < 502
+        // Lua 5.1 API (LuaJIT) ignores __pairs
+        lua_getglobal(state, "pairs");
+        lua_pushcclosure(state, &pairsWithMetamethod, 1);
+        lua_setglobal(state, "pairs");
+#endif // LUA_VERSION_NUM
+    }
+    lua_setmetatable(state, -2);
+}
 } // namespace
+#ifndef PPPLUGIN_LUA_BACKEND_LUAJIT
 static_assert(LUA_VERSION_NUM >= MINIMUM_LUA_VERSION);
+#endif // PPPLUGIN_LUA_BACKEND_LUAJIT
 
 namespace ppplugin {
 LuaState::LuaState()
@@ -23,6 +377,21 @@ LuaState::LuaState()
 {
 }
 
+LuaState::LuaState(std::unique_ptr<LuaAllocator> allocator)
+    : allocator_ { std::move(allocator) }
+    , state_ { nullptr, &lua_close }
+{
+    if (!allocator_) {
+        state_.reset(luaL_newstate());
+        return;
+    }
+    state_.reset(lua_newstate(
+        [](void* allocator, void* block, std::size_t old_size, std::size_t new_size) {
+            return static_cast<LuaAllocator*>(allocator)->reallocate(block, old_size, new_size);
+        },
+        allocator_.get()));
+}
+
 LuaState::LuaState(lua_State* state)
     : state_ { state, [](lua_State*) { } }
 {
@@ -38,6 +407,25 @@ std::optional<std::string> LuaState::topString()
     return std::nullopt;
 }
 
+std::optional<std::string_view> LuaState::topStringView()
+{
+    if (!isString()) {
+        return std::nullopt;
+    }
+    getRegistryField(state(), RESULT_ANCHOR_KEY);
+    if (!lua_istable(state(), -1)) {
+        // no active result guard
+        discardTop();
+        return std::nullopt;
+    }
+    std::size_t result_length {};
+    const char* result = lua_tolstring(state(), -2, &result_length);
+    lua_pushvalue(state(), -2);
+    lua_rawseti(state(), -2, static_cast<lua_Integer>(lua_rawlen(state(), -2) + 1));
+    discardTop();
+    return std::string_view { result, result_length };
+}
+
 std::optional<bool> LuaState::topBool()
 {
     if (isBool()) {
@@ -68,9 +456,32 @@ const void* LuaState::topPointer()
     return lua_topointer(state(), -1);
 }
 
-void LuaState::discardTop()
+void LuaState::discardTop(int count)
+{
+    lua_pop(state(), count);
+}
+
+void LuaState::duplicateTop()
 {
-    lua_pop(state(), 1);
+    lua_pushvalue(state(), -1);
+}
+
+lua_State* LuaState::pushThread()
+{
+    return lua_newthread(state());
+}
+
+LuaState::ResumeStatus LuaState::resume(std::size_t argument_count, int& result_count)
+{
+    resetExecutionBudget(state());
+    auto status = detail::lua::resume(state(), static_cast<int>(argument_count), result_count);
+    if (status == LUA_OK) {
+        return ResumeStatus::finished;
+    }
+    if (status == LUA_YIELD) {
+        return ResumeStatus::yielded;
+    }
+    return ResumeStatus::failed;
 }
 
 void LuaState::pushOne(double value)
@@ -139,6 +550,56 @@ bool LuaState::isTable()
     return lua_type(state(), -1) == LUA_TTABLE;
 }
 
+void LuaState::setExecutionLimits(const LuaExecutionLimits& limits)
+{
+    if (limits.instructionLimit == 0 && limits.timeLimit.count() == 0) {
+        lua_sethook(state(), nullptr, 0, 0);
+        lua_pushnil(state());
+        setRegistryField(state(), EXECUTION_BUDGET_KEY);
+        detail::lua::setJitEnabled(state(), true);
+        return;
+    }
+    const auto hook_interval = static_cast<int>(limits.instructionLimit == 0
+            ? EXECUTION_HOOK_INTERVAL
+            : std::min(limits.instructionLimit, EXECUTION_HOOK_INTERVAL));
+    // owned by registry; trivially destructible, thus no __gc required
+    new (lua_newuserdata(state(), sizeof(ExecutionBudget))) ExecutionBudget { limits, hook_interval, 0, {}, false };
+    setRegistryField(state(), EXECUTION_BUDGET_KEY);
+    lua_sethook(state(), &executionLimitHook, LUA_MASKCOUNT, hook_interval);
+    detail::lua::setJitEnabled(state(), false);
+}
+
+bool LuaState::isExecutionLimitExceeded()
+{
+    const auto* budget = executionBudget(state());
+    return budget != nullptr && budget->isExceeded;
+}
+
+CallError LuaState::popCallError(int error)
+{
+    auto message = error == LUA_ERRRUN ? topString().value_or("?") : "";
+    discardTop();
+    return CallError {
+        isExecutionLimitExceeded() ? CallErrorCode::timeout : CallErrorCode::unknown,
+        format("Unable to call function. Code: '{}'. Error: '{}'", error, message)
+    };
+}
+
+bool LuaState::setGarbageCollectorOptions(const LuaGarbageCollectorOptions& options)
+{
+    if (options.mode == LuaGarbageCollectorMode::generational) {
+        return detail::lua::setGenerationalGc(state());
+    }
+    detail::lua::setIncrementalGc(state(), options.pause, options.stepMultiplier);
+    return true;
+}
+
+bool LuaState::collectGarbage(std::size_t step_size)
+{
+    const auto clamped_step_size = std::min(step_size, static_cast<std::size_t>(std::numeric_limits<int>::max()));
+    return lua_gc(state(), LUA_GCSTEP, static_cast<int>(clamped_step_size)) != 0;
+}
+
 void LuaState::registerPanicHandler(LuaCFunction handler)
 {
     lua_atpanic(state(), handler);
@@ -146,10 +607,26 @@ void LuaState::registerPanicHandler(LuaCFunction handler)
 
 int LuaState::pcall(std::size_t argument_count, std::size_t return_count)
 {
+    resetExecutionBudget(state());
     // TODO: have message handler on stack for lua_pcall (last parameter)
     return lua_pcall(state(), argument_count, return_count, 0);
 }
 
+int LuaState::storeInRegistry()
+{
+    return luaL_ref(state(), LUA_REGISTRYINDEX);
+}
+
+void LuaState::pushFromRegistry(int reference)
+{
+    lua_rawgeti(state(), LUA_REGISTRYINDEX, reference);
+}
+
+void LuaState::removeFromRegistry(int reference)
+{
+    luaL_unref(state(), LUA_REGISTRYINDEX, reference);
+}
+
 void LuaState::markGlobal(const std::string& variable_name)
 {
     lua_setglobal(state(), variable_name.c_str());
@@ -183,6 +660,64 @@ void LuaState::endTable(int table_index, std::size_t table_size)
     }
 }
 
+std::size_t LuaState::arrayLength()
+{
+    return lua_rawlen(state(), -1);
+}
+
+std::size_t LuaState::tableSize()
+{
+    std::size_t size = 0;
+    lua_pushnil(state());
+    while (lua_next(state(), -2) != 0) {
+        lua_pop(state(), 1);
+        ++size;
+    }
+    return size;
+}
+
+void LuaState::pushArrayElement(std::size_t index)
+{
+    lua_rawgeti(state(), -1, static_cast<lua_Integer>(index));
+}
+
+void LuaState::pushBuffer(detail::lua::BufferView buffer)
+{
+    new (lua_newuserdata(state(), sizeof(BufferView))) BufferView { std::move(buffer) };
+    if (luaL_newmetatable(state(), BUFFER_METATABLE) != 0) {
+        lua_pushcfunction(state(), &bufferGet);
+        lua_setfield(state(), -2, "__index");
+        lua_pushcfunction(state(), &bufferSet);
+        lua_setfield(state(), -2, "__newindex");
+        lua_pushcfunction(state(), &bufferLength);
+        lua_setfield(state(), -2, "__len");
+        lua_pushcfunction(state(), &bufferDestroy);
+        lua_setfield(state(), -2, "__gc");
+    }
+    lua_setmetatable(state(), -2);
+}
+
+std::optional<detail::lua::BufferView> LuaState::topBufferView()
+{
+    if (auto* buffer = luaL_testudata(state(), -1, BUFFER_METATABLE)) {
+        return *static_cast<BufferView*>(buffer);
+    }
+    return std::nullopt;
+}
+
+void LuaState::pushOne(const LuaSharedTable& value)
+{
+    pushSharedTable(state(), value);
+}
+
+std::optional<LuaSharedTable> LuaState::topSharedTable()
+{
+    if (auto* table = luaL_testudata(state(), -1, SHARED_TABLE_METATABLE)) {
+        return *static_cast<LuaSharedTable*>(table);
+    }
+    return std::nullopt;
+}
+
 bool LuaState::pushNextTableItem(bool is_first_iteration)
 {
     if (is_first_iteration) {
@@ -221,4 +756,36 @@ void LuaState::dumpStack(std::ostream& out, int start_index, int end_index
         out << i << ": (" << type_name << ")\n";
     }
 }
+
+LuaResultGuard::LuaResultGuard(LuaState& state)
+    : state_ { state.state() }
+{
+    getRegistryField(state_, RESULT_ANCHOR_KEY);
+    if (lua_istable(state_, -1)) {
+        previous_count_ = lua_rawlen(state_, -1);
+    } else {
+        lua_pop(state_, 1);
+        lua_newtable(state_);
+        lua_pushvalue(state_, -1);
+        setRegistryField(state_, RESULT_ANCHOR_KEY);
+        is_outermost_ = true;
+    }
+    lua_pop(state_, 1);
+}
+
+LuaResultGuard::~LuaResultGuard()
+{
+    if (is_outermost_) {
+        lua_pushnil(state_);
+        setRegistryField(state_, RESULT_ANCHOR_KEY);
+        return;
+    }
+    getRegistryField(state_, RESULT_ANCHOR_KEY);
+    // remove from the end to keep the anchored strings a sequence
+    for (auto index = lua_rawlen(state_, -1); index > previous_count_; --index) {
+        lua_pushnil(state_);
+        lua_rawseti(state_, -2, static_cast<lua_Integer>(index));
+    }
+    lua_pop(state_, 1);
+}
 } // namespace ppplugin
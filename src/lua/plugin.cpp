@@ -3,7 +3,32 @@
 namespace ppplugin {
 Expected<LuaPlugin, LoadError> LuaPlugin::load(const std::filesystem::path& plugin_library_path, bool auto_run)
 {
-    return LuaScript::load(plugin_library_path, auto_run)
+    LoadOptions options;
+    options.autoRun = auto_run;
+    return load(plugin_library_path, options);
+}
+
+Expected<LuaPlugin, LoadError> LuaPlugin::load(const std::filesystem::path& plugin_library_path, const LoadOptions& options)
+{
+    return LuaScript::load(plugin_library_path, options)
+        .andThen([](auto script) {
+            LuaPlugin new_plugin { std::move(script) };
+            return new_plugin;
+        });
+}
+
+Expected<LuaPlugin, LoadError> LuaPlugin::loadFromBuffer(
+    std::string_view source_or_bytecode, const std::string& chunk_name, bool auto_run)
+{
+    LoadOptions options;
+    options.autoRun = auto_run;
+    return loadFromBuffer(source_or_bytecode, chunk_name, options);
+}
+
+Expected<LuaPlugin, LoadError> LuaPlugin::loadFromBuffer(
+    std::string_view source_or_bytecode, const std::string& chunk_name, const LoadOptions& options)
+{
+    return LuaScript::loadFromBuffer(source_or_bytecode, chunk_name, options)
         .andThen([](auto script) {
             LuaPlugin new_plugin { std::move(script) };
             return new_plugin;
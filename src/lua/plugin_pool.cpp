@@ -0,0 +1,145 @@
+#include "ppplugin/lua/plugin_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#ifdef PPPLUGIN_CPP17_COMPATIBILITY
+#include <mutex>
+#endif // PPPLUGIN_CPP17_COMPATIBILITY
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr auto INDEX_BITS = 32U;
+// calls typically take microseconds; spin for about as long before blocking
+constexpr auto MAX_SPIN_COUNT = 64U;
+constexpr std::uint64_t INDEX_MASK = (std::uint64_t { 1 } << INDEX_BITS) - 1;
+
+[[nodiscard]] constexpr std::uint64_t nextHead(std::uint64_t previous_head, std::uint64_t new_top)
+{
+    return (((previous_head >> INDEX_BITS) + 1) << INDEX_BITS) | new_top;
+}
+} // namespace
+
+namespace ppplugin {
+Expected<LuaPluginPool, LoadError> LuaPluginPool::load(
+    const std::filesystem::path& script_path, std::size_t size, const LuaScript::LoadOptions& options)
+{
+    if (size == 0) {
+        size = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    auto state_options = options;
+    // functions are only defined after running the script
+    state_options.autoRun = true;
+    auto load_scripts = [size](const auto& load_script) -> Expected<LuaPluginPool, LoadError> {
+        std::vector<LuaScript> scripts;
+        scripts.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            auto script = load_script();
+            if (!script) {
+                return script.error();
+            }
+            scripts.push_back(std::move(*script));
+        }
+        return LuaPluginPool { std::move(scripts) };
+    };
+
+    if (!state_options.bytecodeCacheDirectory.empty()) {
+        // cache provides the bytecode after the first state was loaded
+        return load_scripts([&script_path, &state_options]() {
+            return LuaScript::load(script_path, state_options);
+        });
+    }
+    return LuaScript::compile(script_path).andThen([&script_path, &state_options, &load_scripts](const std::string& bytecode) {
+        // same chunk name as luaL_loadfile for consistent error messages
+        const auto chunk_name = "@" + script_path.string();
+        return load_scripts([&bytecode, &chunk_name, &state_options]() {
+            return LuaScript::loadFromBuffer(bytecode, chunk_name, state_options);
+        });
+    });
+}
+
+LuaPluginPool::LuaPluginPool(std::vector<LuaScript>&& scripts)
+    : scripts_ { std::move(scripts) }
+    , free_list_ { std::make_unique<FreeList>(scripts_.size()) }
+{
+}
+
+LuaPluginPool::FreeList::FreeList(std::size_t size)
+    : head_ { size == 0 ? std::uint64_t { 0 } : std::uint64_t { 1 } }
+    , next_ { std::make_unique<std::atomic<std::uint32_t>[]>(size) }
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        // last element points to 0, i.e. end of list
+        next_[i].store(i + 1 < size ? static_cast<std::uint32_t>(i + 2) : 0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t LuaPluginPool::FreeList::acquire()
+{
+    auto spin_count = 0U;
+    auto head = head_.load(std::memory_order_acquire);
+    while (true) {
+        auto top = head & INDEX_MASK;
+        if (top == 0) {
+            // all states are in use
+            if (++spin_count < MAX_SPIN_COUNT) {
+                std::this_thread::yield();
+            } else {
+                wait(head);
+            }
+            head = head_.load(std::memory_order_acquire);
+            continue;
+        }
+        auto next = next_[top - 1].load(std::memory_order_relaxed);
+        if (head_.compare_exchange_weak(head, nextHead(head, next),
+                std::memory_order_acquire, std::memory_order_acquire)) {
+            return top - 1;
+        }
+    }
+}
+
+void LuaPluginPool::FreeList::release(std::size_t index)
+{
+    auto head = head_.load(std::memory_order_relaxed);
+    do {
+        next_[index].store(static_cast<std::uint32_t>(head & INDEX_MASK), std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(head, nextHead(head, index + 1),
+        std::memory_order_seq_cst, std::memory_order_relaxed));
+
+#ifdef PPPLUGIN_CPP17_COMPATIBILITY
+    // sequentially consistent with update of head; either the waiter sees
+    // the new head or this thread sees the waiter
+    if (waiter_count_.load(std::memory_order_seq_cst) > 0) {
+        {
+            // waiter is either blocked or has not yet checked the head
+            const std::lock_guard lock { mutex_ };
+        }
+        available_.notify_one();
+    }
+#else
+    head_.notify_one();
+#endif // PPPLUGIN_CPP17_COMPATIBILITY
+}
+
+void LuaPluginPool::FreeList::wait(std::uint64_t empty_head)
+{
+#ifdef PPPLUGIN_CPP17_COMPATIBILITY
+    waiter_count_.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::unique_lock lock { mutex_ };
+        available_.wait(lock, [this, empty_head]() {
+            return head_.load(std::memory_order_seq_cst) != empty_head;
+        });
+    }
+    waiter_count_.fetch_sub(1, std::memory_order_relaxed);
+#else
+    head_.wait(empty_head, std::memory_order_acquire);
+#endif // PPPLUGIN_CPP17_COMPATIBILITY
+}
+} // namespace ppplugin
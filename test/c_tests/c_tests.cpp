@@ -0,0 +1,186 @@
+#include "test_helper.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <ppplugin/c/plugin.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+class CTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        auto load_result = ppplugin::CPlugin::load("./c_tests/test.so");
+        ASSERT_TRUE(load_result.hasValue());
+
+        plugin = std::make_unique<ppplugin::CPlugin>(std::move(load_result.value()));
+    }
+
+protected:
+    std::unique_ptr<ppplugin::CPlugin> plugin;
+};
+
+TEST_F(CTest, callFunction)
+{
+    auto result = plugin->call<int>("add", 1, 2);
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(0), 3);
+}
+
+TEST_F(CTest, callMissingFunction)
+{
+    auto result = plugin->call<int>("does_not_exist", 1, 2);
+
+    ASSERT_FALSE(result.hasValue());
+    EXPECT_EQ(result.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+}
+
+TEST_F(CTest, callMovedFromPlugin)
+{
+    auto moved = std::move(*plugin);
+    auto result = plugin->call<int>("add", 1, 2); // NOLINT(bugprone-use-after-move)
+    auto add = plugin->function<int(int, int)>("add");
+
+    ASSERT_FALSE(result.hasValue());
+    EXPECT_EQ(result.error().code(), ppplugin::CallErrorCode::notLoaded);
+    ASSERT_FALSE(add.hasValue());
+    EXPECT_EQ(add.error().code(), ppplugin::CallErrorCode::notLoaded);
+    EXPECT_FALSE(plugin->has("add"));
+    EXPECT_TRUE(plugin->symbols().empty());
+    EXPECT_TRUE(moved.has("add"));
+}
+
+TEST_F(CTest, functionHandle)
+{
+    auto add = plugin->function<int(int, int)>("add");
+    auto scale = plugin->function<double(double, int)>("scale");
+
+    ASSERT_TRUE(add.hasValue()) << ppplugin::test::errorOutput(add);
+    ASSERT_TRUE(scale.hasValue()) << ppplugin::test::errorOutput(scale);
+    EXPECT_EQ((*add)(2, 3), 5);
+    EXPECT_EQ((*add)(-2, 2), 0);
+    EXPECT_DOUBLE_EQ((*scale)(1.5, 4), 6.0);
+}
+
+TEST_F(CTest, functionHandleIsCopyable)
+{
+    auto increment = plugin->function<void()>("increment");
+    ASSERT_TRUE(increment.hasValue()) << ppplugin::test::errorOutput(increment);
+
+    const std::vector<ppplugin::CPlugin::Function<void()>> handles(3, *increment);
+    auto before = plugin->global<int>("counter");
+    for (const auto& handle : handles) {
+        handle();
+    }
+    auto after = plugin->global<int>("counter");
+
+    ASSERT_TRUE(before.hasValue() && after.hasValue());
+    EXPECT_EQ(*after - *before, 3);
+}
+
+TEST_F(CTest, functionHandleForMissingFunction)
+{
+    auto handle = plugin->function<void()>("does_not_exist");
+
+    ASSERT_FALSE(handle.hasValue());
+    EXPECT_EQ(handle.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+}
+
+TEST_F(CTest, repeatedLookupOfSameSymbol)
+{
+    for (int i = 0; i < 3; ++i) {
+        auto found = plugin->call<int>("add", static_cast<int>(i), 1);
+        auto missing = plugin->call<int>("does_not_exist", static_cast<int>(i), 1);
+
+        ASSERT_TRUE(found.hasValue()) << ppplugin::test::errorOutput(found);
+        EXPECT_EQ(found.valueOr(0), i + 1);
+        ASSERT_FALSE(missing.hasValue());
+        EXPECT_EQ(missing.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+    }
+}
+
+TEST_F(CTest, globalVariable)
+{
+    ASSERT_TRUE(plugin->global("counter", 42).hasValue());
+    auto result = plugin->global<int>("counter");
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(0), 42);
+}
+
+TEST(CPluginTest, loadWithSymbolIndex)
+{
+    ppplugin::CPlugin::LoadOptions options;
+    options.indexSymbols = true;
+    auto plugin = ppplugin::CPlugin::load("./c_tests/test.so", options);
+    ASSERT_TRUE(plugin.hasValue());
+
+    EXPECT_TRUE(std::is_sorted(plugin->symbols().begin(), plugin->symbols().end()));
+    EXPECT_THAT(plugin->symbols(), testing::IsSupersetOf({ "add", "counter", "increment", "scale" }));
+    EXPECT_TRUE(plugin->has("add"));
+    EXPECT_FALSE(plugin->has("does_not_exist"));
+
+    auto found = plugin->call<int>("add", 1, 2);
+    auto missing = plugin->call<int>("does_not_exist", 1, 2);
+    ASSERT_TRUE(found.hasValue()) << ppplugin::test::errorOutput(found);
+    EXPECT_EQ(found.valueOr(0), 3);
+    ASSERT_FALSE(missing.hasValue());
+    EXPECT_EQ(missing.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+}
+
+TEST(CPluginTest, loadWithoutSymbolIndex)
+{
+    auto plugin = ppplugin::CPlugin::load("./c_tests/test.so");
+    ASSERT_TRUE(plugin.hasValue());
+
+    EXPECT_TRUE(plugin->symbols().empty());
+    EXPECT_TRUE(plugin->has("add"));
+    EXPECT_FALSE(plugin->has("does_not_exist"));
+}
+
+TEST(CPluginTest, loadStrippedWithSymbolIndex)
+{
+    ppplugin::CPlugin::LoadOptions options;
+    options.indexSymbols = true;
+    auto plugin = ppplugin::CPlugin::load("./c_tests/test_stripped.so", options);
+    ASSERT_TRUE(plugin.hasValue());
+
+    EXPECT_TRUE(plugin->has("add"));
+    EXPECT_FALSE(plugin->has("does_not_exist"));
+    auto result = plugin->call<int>("add", 1, 2);
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(0), 3);
+}
+
+TEST(CPluginTest, loadMissingFile)
+{
+    auto plugin = ppplugin::CPlugin::load("./c_tests/does_not_exist.so");
+
+    ASSERT_FALSE(plugin.hasValue());
+    EXPECT_EQ(plugin.error().code(), ppplugin::LoadErrorCode::fileNotFound);
+}
+
+TEST(CPluginTest, loadWithDifferentBindings)
+{
+    using Binding = ppplugin::CPlugin::LoadOptions::Binding;
+    for (auto binding : { Binding::lazy, Binding::now }) {
+        for (bool global : { false, true }) {
+            ppplugin::CPlugin::LoadOptions options;
+            options.binding = binding;
+            options.global = global;
+            // AddressSanitizer aborts when a library is loaded with RTLD_DEEPBIND
+            options.deepBind = !global && !ppplugin::test::IS_ADDRESS_SANITIZED;
+            options.noDelete = global;
+            auto plugin = ppplugin::CPlugin::load("./c_tests/test.so", options);
+            ASSERT_TRUE(plugin.hasValue());
+
+            auto result = plugin->call<int>("add", 1, 2);
+            ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+            EXPECT_EQ(result.valueOr(0), 3);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef PPPLUGIN_TEST_VERSION
+#define PPPLUGIN_TEST_VERSION 1
+#endif // PPPLUGIN_TEST_VERSION
+
+int counter = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+int add(int lhs, int rhs)
+{
+    return lhs + rhs;
+}
+
+double scale(double value, int factor)
+{
+    return value * factor;
+}
+
+void increment(void)
+{
+    ++counter;
+}
+
+int get_version(void)
+{
+    return PPPLUGIN_TEST_VERSION;
+}
@@ -0,0 +1,75 @@
+#include "test_helper.h"
+
+#include <gtest/gtest.h>
+
+#include <ppplugin/cpp/plugin.h>
+
+#include <memory>
+#include <string>
+
+class CppTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        auto load_result = ppplugin::CppPlugin::load("./cpp_tests/test.so");
+        ASSERT_TRUE(load_result.hasValue());
+
+        plugin = std::make_unique<ppplugin::CppPlugin>(std::move(load_result.value()));
+    }
+
+protected:
+    std::unique_ptr<ppplugin::CppPlugin> plugin;
+};
+
+TEST_F(CppTest, callFunction)
+{
+    auto result = plugin->call<int>("add", 1, 2);
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(0), 3);
+}
+
+TEST_F(CppTest, callMissingFunction)
+{
+    auto result = plugin->call<int>("does_not_exist", 1, 2);
+
+    ASSERT_FALSE(result.hasValue());
+    EXPECT_EQ(result.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+}
+
+TEST_F(CppTest, functionHandle)
+{
+    auto concat = plugin->function<std::string(const std::string&, const std::string&)>("concat");
+
+    ASSERT_TRUE(concat.hasValue()) << ppplugin::test::errorOutput(concat);
+    EXPECT_EQ((*concat)("abc", "def"), "abcdef");
+    EXPECT_EQ((*concat)("", "x"), "x");
+}
+
+TEST_F(CppTest, functionHandleWithReferenceArgument)
+{
+    auto append = plugin->function<void(std::string&, const std::string&)>("append");
+    ASSERT_TRUE(append.hasValue()) << ppplugin::test::errorOutput(append);
+
+    std::string target = "a";
+    (*append)(target, "b");
+    (*append)(target, "c");
+
+    EXPECT_EQ(target, "abc");
+}
+
+TEST(CppPluginTest, loadWithSymbolIndex)
+{
+    ppplugin::CppPlugin::LoadOptions options;
+    options.indexSymbols = true;
+    auto plugin = ppplugin::CppPlugin::load("./cpp_tests/test.so", options);
+    ASSERT_TRUE(plugin.hasValue());
+
+    EXPECT_TRUE(plugin->has("add"));
+    EXPECT_TRUE(plugin->has("concat"));
+    EXPECT_FALSE(plugin->has("does_not_exist"));
+
+    auto result = plugin->call<int>("add", 1, 2);
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(0), 3);
+}
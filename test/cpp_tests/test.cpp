@@ -0,0 +1,26 @@
+#include <boost/dll/alias.hpp>
+
+#include <string>
+
+namespace cpp_test_plugin {
+int add(int lhs, int rhs)
+{
+    return lhs + rhs;
+}
+
+std::string concat(const std::string& lhs, const std::string& rhs)
+{
+    return lhs + rhs;
+}
+
+void append(std::string& target, const std::string& suffix)
+{
+    target += suffix;
+}
+} // namespace cpp_test_plugin
+
+// NOLINTBEGIN
+BOOST_DLL_ALIAS(cpp_test_plugin::add, add)
+BOOST_DLL_ALIAS(cpp_test_plugin::concat, concat)
+BOOST_DLL_ALIAS(cpp_test_plugin::append, append)
+// NOLINTEND
@@ -3,7 +3,59 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <ppplugin/lua/lua_allocator.h>
+#include <ppplugin/lua/lua_buffer.h>
+#include <ppplugin/lua/lua_shared_table.h>
 #include <ppplugin/lua/plugin.h>
+#include <ppplugin/lua/plugin_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+/**
+ * Allocator which fails all allocations once it is exhausted.
+ */
+class ExhaustibleAllocator final : public ppplugin::LuaAllocator {
+public:
+    bool exhausted { false };
+
+protected:
+    void* allocate(std::size_t size) override
+    {
+        return exhausted ? nullptr : std::malloc(size); // NOLINT(cppcoreguidelines-no-malloc)
+    }
+    void deallocate(void* block, std::size_t /*size*/) override
+    {
+        std::free(block); // NOLINT(cppcoreguidelines-no-malloc)
+    }
+};
+
+/**
+ * Pool allocator which fails to allocate new chunks once it is exhausted.
+ */
+class ExhaustiblePoolAllocator final : public ppplugin::LuaPoolAllocator {
+public:
+    using LuaPoolAllocator::LuaPoolAllocator;
+
+    bool exhausted { false };
+
+protected:
+    void* allocateChunk(std::size_t size) override
+    {
+        return exhausted ? nullptr : LuaPoolAllocator::allocateChunk(size);
+    }
+};
+} // namespace
 
 class LuaTest : public testing::Test {
 protected:
@@ -68,6 +120,58 @@ TEST_F(LuaTest, callFunctionWithArrayResult)
     EXPECT_THAT(result.valueOr(std::vector<std::string> {}), testing::ElementsAre("a", "b", "c"));
 }
 
+TEST_F(LuaTest, callFunctionWithLargeArrayResult)
+{
+    constexpr int ARRAY_SIZE = 100000;
+    std::vector<int> array(ARRAY_SIZE);
+    std::iota(array.begin(), array.end(), 0);
+
+    auto result = plugin->call<std::vector<int>>("create_array", ARRAY_SIZE);
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(std::vector<int> {}), array);
+}
+
+TEST_F(LuaTest, failToConvertNonSequenceToArray)
+{
+    const auto sparse_table = std::map<int, std::string> { { 1, "a" }, { 3, "c" } };
+    const auto mixed_table = std::map<std::string, std::string> { { "1", "a" }, { "x", "b" } };
+    const auto sequence_table = std::map<int, std::string> { { 2, "b" }, { 1, "a" } };
+
+    auto sparse_result = plugin->call<std::vector<std::string>>("identity", sparse_table);
+    auto mixed_result = plugin->call<std::vector<std::string>>("identity", mixed_table);
+    auto sequence_result = plugin->call<std::vector<std::string>>("identity", sequence_table);
+
+    EXPECT_FALSE(sparse_result.hasValue());
+    EXPECT_FALSE(mixed_result.hasValue());
+    EXPECT_THAT(sequence_result.valueOr(std::vector<std::string> {}), testing::ElementsAre("a", "b"));
+}
+
+TEST_F(LuaTest, shareBufferWithLua)
+{
+    ppplugin::LuaBuffer<double> buffer { std::vector<double> { 1.0, 2.5, -3.0 } };
+
+    auto result = plugin->call<ppplugin::LuaBuffer<double>>("scale_buffer", buffer, 2);
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result->data(), buffer.data());
+    EXPECT_THAT(buffer, testing::ElementsAre(2.0, 5.0, -6.0));
+}
+
+TEST_F(LuaTest, failToAccessBufferOutOfRange)
+{
+    ppplugin::LuaBuffer<std::int32_t> buffer { 2 };
+
+    auto valid_result = plugin->call<void>("write_buffer", buffer, 2, 7);
+    auto invalid_result = plugin->call<void>("write_buffer", buffer, 3, 7);
+    auto wrong_type_result = plugin->call<ppplugin::LuaBuffer<double>>("identity", buffer);
+
+    EXPECT_TRUE(valid_result.hasValue());
+    EXPECT_FALSE(invalid_result.hasValue());
+    EXPECT_FALSE(wrong_type_result.hasValue());
+    EXPECT_THAT(buffer, testing::ElementsAre(0, 7));
+}
+
 TEST_F(LuaTest, callFunctionWithMapResult)
 {
     using ResultType = std::map<std::string, int>;
@@ -93,3 +197,550 @@ TEST_F(LuaTest, nestedTable)
     ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
     EXPECT_EQ(result.valueOr(ResultType {}), value);
 }
+
+TEST_F(LuaTest, callFunctionHandle)
+{
+    auto function = plugin->function("access_table");
+    ASSERT_TRUE(function.hasValue()) << ppplugin::test::errorOutput(function);
+
+    const auto example_map = std::map<std::string, int> { { "a", 1 }, { "b", 2 } };
+    auto result_a = function->call<int>(example_map, "a");
+    auto result_b = function->call<int>(example_map, "b");
+
+    EXPECT_EQ(result_a.valueOr(-1), 1);
+    EXPECT_EQ(result_b.valueOr(-1), 2);
+}
+
+TEST_F(LuaTest, functionHandleSurvivesReassignment)
+{
+    auto function = plugin->function("return_array");
+    ASSERT_TRUE(function.hasValue()) << ppplugin::test::errorOutput(function);
+
+    ASSERT_TRUE(plugin->global("return_array", 1).hasValue());
+    auto result = function->call<std::vector<std::string>>();
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_THAT(result.valueOr(std::vector<std::string> {}), testing::ElementsAre("a", "b", "c"));
+}
+
+TEST_F(LuaTest, resolveInvalidFunctionHandle)
+{
+    ASSERT_TRUE(plugin->global("not_a_function", 1).hasValue());
+
+    auto missing_function = plugin->function("does_not_exist");
+    auto invalid_function = plugin->function("not_a_function");
+
+    ASSERT_FALSE(missing_function.hasValue());
+    ASSERT_FALSE(invalid_function.hasValue());
+    EXPECT_EQ(missing_function.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+    EXPECT_EQ(invalid_function.error().code(), ppplugin::CallErrorCode::incorrectType);
+}
+
+TEST_F(LuaTest, callTypedFunctionCopies)
+{
+    auto function = plugin->function<bool(int, std::string, bool)>("accept_number_string_bool");
+    ASSERT_TRUE(function.hasValue()) << ppplugin::test::errorOutput(function);
+
+    std::vector<ppplugin::LuaFunction<bool(int, std::string, bool)>> functions(3, *function);
+    function = ppplugin::CallError { ppplugin::CallErrorCode::unknown };
+
+    for (const auto& copied_function : functions) {
+        ASSERT_TRUE(copied_function);
+        EXPECT_TRUE(copied_function(1, "a", true).valueOr(false));
+        EXPECT_TRUE(copied_function(2, "b", false).valueOr(false));
+    }
+}
+
+TEST(LuaFunctionTest, callTypedFunctionWithMultipleResults)
+{
+    auto plugin = ppplugin::LuaPlugin::loadFromBuffer("function swap(a, b) return b, a end", "=buffer");
+    ASSERT_TRUE(plugin.hasValue());
+    auto swap = plugin->function<std::tuple<std::string, int>(int, std::string)>("swap");
+    auto invalid_swap = plugin->function<std::tuple<int, int>(int, std::string)>("swap");
+    ASSERT_TRUE(swap.hasValue()) << ppplugin::test::errorOutput(swap);
+    ASSERT_TRUE(invalid_swap.hasValue()) << ppplugin::test::errorOutput(invalid_swap);
+
+    for (int i = 0; i < 3; ++i) {
+        auto invalid_result = (*invalid_swap)(i, "a");
+        auto result = (*swap)(i, "a");
+
+        EXPECT_FALSE(invalid_result.hasValue());
+        ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+        EXPECT_EQ(*result, std::make_tuple(std::string { "a" }, i));
+    }
+}
+
+TEST_F(LuaTest, resolveInvalidTypedFunction)
+{
+    ASSERT_TRUE(plugin->global("not_a_function", 1).hasValue());
+
+    auto missing_function = plugin->function<int()>("does_not_exist");
+    auto invalid_function = plugin->function<int()>("not_a_function");
+
+    ASSERT_FALSE(missing_function.hasValue());
+    ASSERT_FALSE(invalid_function.hasValue());
+    EXPECT_EQ(missing_function.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+    EXPECT_EQ(invalid_function.error().code(), ppplugin::CallErrorCode::incorrectType);
+}
+
+TEST_F(LuaTest, callFunctionBatch)
+{
+    const std::vector<std::tuple<int, std::string, bool>> arguments {
+        { 1, "a", true }, { 2, "b", false }
+    };
+    const std::vector<std::string> invalid_arguments { "a", "b" };
+
+    auto results = plugin->callBatch<bool>("accept_number_string_bool", arguments);
+    auto invalid_results = plugin->callBatch<bool>("accept_number_string_bool", invalid_arguments);
+    auto missing_results = plugin->callBatch<int>("does_not_exist", invalid_arguments);
+
+    ASSERT_EQ(results.size(), 2U);
+    EXPECT_TRUE(results[0].valueOr(false));
+    EXPECT_TRUE(results[1].valueOr(false));
+    ASSERT_EQ(invalid_results.size(), 2U);
+    EXPECT_FALSE(invalid_results[0].valueOr(true));
+    ASSERT_EQ(missing_results.size(), 2U);
+    EXPECT_EQ(missing_results[1].error().code(), ppplugin::CallErrorCode::symbolNotFound);
+}
+
+TEST_F(LuaTest, interleaveAsyncCalls)
+{
+    auto first_call = plugin->callAsync<int>("sum_requested_values", 2);
+    auto second_call = plugin->callAsync<int>("sum_requested_values", 1);
+    ASSERT_TRUE(first_call.hasValue()) << ppplugin::test::errorOutput(first_call);
+    ASSERT_TRUE(second_call.hasValue()) << ppplugin::test::errorOutput(second_call);
+
+    EXPECT_EQ(first_call->yielded<int>(), 1);
+    EXPECT_EQ(second_call->yielded<int>(), 1);
+    ASSERT_TRUE(first_call->resume(10).hasValue());
+    ASSERT_TRUE(second_call->resume(5).hasValue());
+    EXPECT_EQ(first_call->yielded<int>(), 2);
+    EXPECT_TRUE(second_call->isFinished());
+    EXPECT_FALSE(first_call->isFinished());
+    ASSERT_TRUE(first_call->resume(20).hasValue());
+
+    EXPECT_TRUE(first_call->isFinished());
+    EXPECT_EQ(first_call->result().valueOr(-1), 30);
+    EXPECT_EQ(second_call->result().valueOr(-1), 5);
+    EXPECT_FALSE(first_call->resume(30).hasValue());
+}
+
+TEST_F(LuaTest, failAsyncCall)
+{
+    auto missing_call = plugin->callAsync<void>("does_not_exist");
+    auto failing_call = plugin->callAsync<void>("fail_after_yield");
+    ASSERT_FALSE(missing_call.hasValue());
+    ASSERT_TRUE(failing_call.hasValue()) << ppplugin::test::errorOutput(failing_call);
+
+    auto resume_result = failing_call->resume();
+
+    EXPECT_EQ(missing_call.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+    EXPECT_FALSE(resume_result.hasValue());
+    EXPECT_TRUE(failing_call->isFinished());
+    EXPECT_FALSE(failing_call->result().hasValue());
+}
+
+TEST_F(LuaTest, abortCallExceedingInstructionLimit)
+{
+    plugin->setExecutionLimits({ 100000, {} });
+
+    auto aborted_result = plugin->call<void>("loop_forever");
+    auto result = plugin->call<int>("create_table", 10);
+
+    ASSERT_FALSE(aborted_result.hasValue());
+    EXPECT_EQ(aborted_result.error().code(), ppplugin::CallErrorCode::timeout);
+    EXPECT_EQ(result.valueOr(-1), 10);
+}
+
+TEST_F(LuaTest, abortCallExceedingTimeLimit)
+{
+    plugin->setExecutionLimits({ 0, std::chrono::milliseconds { 50 } });
+
+    auto aborted_result = plugin->call<void>("loop_forever");
+    auto async_call = plugin->callAsync<void>("loop_forever");
+    plugin->setExecutionLimits({});
+    auto result = plugin->call<int>("create_table", 10);
+
+    ASSERT_FALSE(aborted_result.hasValue());
+    EXPECT_EQ(aborted_result.error().code(), ppplugin::CallErrorCode::timeout);
+    ASSERT_FALSE(async_call.hasValue());
+    EXPECT_EQ(async_call.error().code(), ppplugin::CallErrorCode::timeout);
+    EXPECT_EQ(result.valueOr(-1), 10);
+}
+
+TEST(LuaAllocatorTest, usePoolAllocator)
+{
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.allocator = []() { return std::make_unique<ppplugin::LuaPoolAllocator>(); };
+    auto plugin = ppplugin::LuaPlugin::load("./lua_tests/test.lua", options);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+    ASSERT_NE(plugin->raw().allocator(), nullptr);
+
+    auto result = plugin->call<int>("create_table", 10000);
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(-1), 10000);
+    auto serialized = plugin->call<std::string>("serialize_array", std::vector<std::string> { "b", "a" });
+    EXPECT_EQ(serialized.valueOr(""), "1:a,2:b,");
+    EXPECT_GT(plugin->raw().allocator()->memoryUsage(), 0U);
+}
+
+TEST(LuaAllocatorTest, failCallExceedingMemoryLimit)
+{
+    static constexpr std::size_t MEMORY_LIMIT = 1024 * 1024;
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.allocator = []() { return std::make_unique<ppplugin::LuaPoolAllocator>(MEMORY_LIMIT); };
+    auto plugin = ppplugin::LuaPlugin::load("./lua_tests/test.lua", options);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+
+    auto exceeding_result = plugin->call<int>("create_table", 1000000);
+    EXPECT_FALSE(exceeding_result.hasValue());
+    EXPECT_LE(plugin->raw().allocator()->memoryUsage(), MEMORY_LIMIT);
+
+    auto result = plugin->call<int>("create_table", 10);
+    EXPECT_EQ(result.valueOr(-1), 10);
+}
+
+TEST(LuaAllocatorTest, shrinkAtMemoryLimit)
+{
+    ppplugin::LuaPoolAllocator allocator { 1024 };
+    auto* block = allocator.reallocate(nullptr, 0, 1024);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(allocator.reallocate(nullptr, 0, 1), nullptr);
+
+    // moves block into pool
+    auto* shrunk_block = allocator.reallocate(block, 1024, 16);
+    ASSERT_NE(shrunk_block, nullptr);
+    EXPECT_EQ(allocator.memoryUsage(), 16);
+    EXPECT_EQ(allocator.reallocate(shrunk_block, 16, 0), nullptr);
+    EXPECT_EQ(allocator.memoryUsage(), 0);
+}
+
+TEST(LuaAllocatorTest, keepBlockIfShrinkingFails)
+{
+    ExhaustibleAllocator allocator;
+    auto* block = allocator.reallocate(nullptr, 0, 512);
+    ASSERT_NE(block, nullptr);
+    allocator.exhausted = true;
+
+    EXPECT_EQ(allocator.reallocate(block, 512, 64), block);
+    EXPECT_EQ(allocator.reallocate(block, 64, 128), nullptr);
+    EXPECT_EQ(allocator.memoryUsage(), 64);
+    EXPECT_EQ(allocator.reallocate(block, 64, 0), nullptr);
+}
+
+TEST(LuaAllocatorTest, freeMallocBlockIfMovingIntoPoolFails)
+{
+    constexpr std::size_t MEMORY_LIMIT = 1024;
+    ExhaustiblePoolAllocator allocator { MEMORY_LIMIT };
+    auto* block = allocator.reallocate(nullptr, 0, MEMORY_LIMIT);
+    ASSERT_NE(block, nullptr);
+    allocator.exhausted = true;
+
+    EXPECT_EQ(allocator.reallocate(block, MEMORY_LIMIT, 64), block);
+    EXPECT_EQ(allocator.memoryUsage(), 64);
+    EXPECT_EQ(allocator.reallocate(block, 64, 0), nullptr);
+    EXPECT_EQ(allocator.memoryUsage(), 0);
+
+    // malloc'd block must not be reused as pooled block (would leak)
+    allocator.exhausted = false;
+    auto* pooled_block = allocator.reallocate(nullptr, 0, 64);
+    ASSERT_NE(pooled_block, nullptr);
+    EXPECT_NE(pooled_block, block);
+    EXPECT_EQ(allocator.reallocate(pooled_block, 64, 0), nullptr);
+    EXPECT_EQ(allocator.memoryUsage(), 0);
+}
+
+TEST(LuaAllocatorTest, failToLoadWithTooLowMemoryLimit)
+{
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.allocator = []() { return std::make_unique<ppplugin::LuaPoolAllocator>(1024); };
+    auto plugin = ppplugin::LuaPlugin::load("./lua_tests/test.lua", options);
+
+    EXPECT_FALSE(plugin.hasValue());
+}
+
+TEST(LuaGarbageCollectorTest, collectGarbageExplicitly)
+{
+    static constexpr auto MAXIMUM_STEPS = 100000;
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.allocator = []() { return std::make_unique<ppplugin::LuaPoolAllocator>(); };
+    // delay automatic collection to leave garbage of the call behind
+    options.garbageCollector.pause = 1000;
+    auto plugin = ppplugin::LuaPlugin::load("./lua_tests/test.lua", options);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+
+    ASSERT_EQ(plugin->call<int>("create_table", 5000).valueOr(-1), 5000);
+    const auto usage_with_garbage = plugin->raw().allocator()->memoryUsage();
+    auto steps = 0;
+    while (!plugin->collectGarbage() && steps < MAXIMUM_STEPS) {
+        ++steps;
+    }
+
+    EXPECT_LT(steps, MAXIMUM_STEPS);
+    EXPECT_LT(plugin->raw().allocator()->memoryUsage(), usage_with_garbage);
+}
+
+TEST(LuaGarbageCollectorTest, callWithGenerationalMode)
+{
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.garbageCollector.mode = ppplugin::LuaGarbageCollectorMode::generational;
+    auto plugin = ppplugin::LuaPlugin::load("./lua_tests/test.lua", options);
+    if (!plugin) {
+        GTEST_SKIP() << "Generational mode not supported: " << ppplugin::test::errorOutput(plugin);
+    }
+
+    EXPECT_EQ(plugin->call<int>("create_table", 1000).valueOr(-1), 1000);
+    plugin->collectGarbage(1024);
+    EXPECT_EQ(plugin->call<int>("create_table", 1000).valueOr(-1), 1000);
+}
+
+TEST(LuaBufferTest, loadFromSourceBuffer)
+{
+    auto plugin = ppplugin::LuaPlugin::loadFromBuffer("function add(a, b) return a + b end", "=buffer");
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+
+    auto result = plugin->call<int>("add", 1, 2);
+    EXPECT_EQ(result.valueOr(-1), 3);
+}
+
+TEST(LuaBufferTest, loadFromBufferWithOptions)
+{
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.allocator = []() { return std::make_unique<ppplugin::LuaPoolAllocator>(); };
+    options.sharedGlobals.emplace("config", ppplugin::LuaSharedTable { ppplugin::LuaSharedTable::Array { std::int64_t { 5 } } });
+
+    auto plugin = ppplugin::LuaPlugin::loadFromBuffer("function get_config() return config[1] end", "=buffer", options);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+
+    EXPECT_NE(plugin->raw().allocator(), nullptr);
+    EXPECT_EQ(plugin->call<int>("get_config").valueOr(-1), 5);
+}
+
+TEST(LuaBufferTest, failToLoadInvalidBuffer)
+{
+    auto plugin = ppplugin::LuaPlugin::loadFromBuffer("function add(a, b", "=buffer");
+
+    ASSERT_FALSE(plugin.hasValue());
+    EXPECT_EQ(plugin.error().code(), ppplugin::LoadErrorCode::fileInvalid);
+}
+
+TEST(LuaBytecodeCacheTest, reuseAndInvalidateCache)
+{
+    auto directory = std::filesystem::temp_directory_path() / "ppplugin_bytecode_cache_test";
+    std::filesystem::remove_all(directory);
+    auto cache_directory = directory / "cache";
+    auto script_path = directory / "script.lua";
+    std::filesystem::create_directories(directory);
+    std::ofstream { script_path } << "#!/usr/bin/env lua\nfunction get_version() return 1 end";
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.bytecodeCacheDirectory = cache_directory;
+
+    auto first_plugin = ppplugin::LuaPlugin::load(script_path, options);
+    ASSERT_TRUE(first_plugin.hasValue()) << ppplugin::test::errorOutput(first_plugin);
+    ASSERT_FALSE(std::filesystem::is_empty(cache_directory));
+    auto cached_plugin = ppplugin::LuaPlugin::load(script_path, options);
+    ASSERT_TRUE(cached_plugin.hasValue()) << ppplugin::test::errorOutput(cached_plugin);
+    EXPECT_EQ(cached_plugin->call<int>("get_version").valueOr(-1), 1);
+
+    std::ofstream { script_path } << "function get_version() return 2 end";
+    auto modified_plugin = ppplugin::LuaPlugin::load(script_path, options);
+    ASSERT_TRUE(modified_plugin.hasValue()) << ppplugin::test::errorOutput(modified_plugin);
+    EXPECT_EQ(modified_plugin->call<int>("get_version").valueOr(-1), 2);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(LuaBytecodeCacheTest, ignoreUntrustedCacheFile)
+{
+    auto directory = std::filesystem::temp_directory_path() / "ppplugin_untrusted_cache_test";
+    std::filesystem::remove_all(directory);
+    auto cache_directory = directory / "cache";
+    auto script_path = directory / "script.lua";
+    std::filesystem::create_directories(directory);
+    std::ofstream { script_path } << "function get_version() return 1 end";
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.bytecodeCacheDirectory = cache_directory;
+    ASSERT_TRUE(ppplugin::LuaPlugin::load(script_path, options).hasValue());
+    const auto cache_file = std::filesystem::directory_iterator { cache_directory }->path();
+    EXPECT_EQ(std::filesystem::status(cache_file).permissions() & std::filesystem::perms::others_write, std::filesystem::perms::none);
+
+    // cache file writable by others is not used, but replaced
+    std::filesystem::permissions(cache_file, std::filesystem::perms::others_write, std::filesystem::perm_options::add);
+    auto plugin = ppplugin::LuaPlugin::load(script_path, options);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+    EXPECT_EQ(plugin->call<int>("get_version").valueOr(-1), 1);
+    EXPECT_EQ(std::filesystem::status(cache_file).permissions() & std::filesystem::perms::others_write, std::filesystem::perms::none);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_F(LuaTest, callFunctionWithStringViewResult)
+{
+    auto guard = plugin->resultGuard();
+    auto result = plugin->call<std::string_view>("serialize_array", std::vector<std::string> { "b", "a" });
+    auto array_result = plugin->call<std::vector<std::string_view>>("return_array");
+    // trigger collection of unreferenced strings
+    ASSERT_TRUE(plugin->call<void>("collectgarbage").hasValue());
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(result.valueOr(""), "1:a,2:b,");
+    EXPECT_THAT(array_result.valueOr(std::vector<std::string_view> {}), testing::ElementsAre("a", "b", "c"));
+}
+
+TEST_F(LuaTest, nestedResultGuards)
+{
+    ASSERT_TRUE(plugin->global("outer", "outer value").hasValue());
+    ASSERT_TRUE(plugin->global("inner", "inner value").hasValue());
+
+    auto outer_guard = plugin->resultGuard();
+    auto outer_value = plugin->global<std::string_view>("outer");
+    {
+        auto inner_guard = plugin->resultGuard();
+        auto inner_value = plugin->global<std::string_view>("inner");
+        EXPECT_EQ(inner_value.valueOr(""), "inner value");
+    }
+    ASSERT_TRUE(plugin->global("outer", 1).hasValue());
+    ASSERT_TRUE(plugin->call<void>("collectgarbage").hasValue());
+
+    EXPECT_EQ(outer_value.valueOr(""), "outer value");
+}
+
+TEST_F(LuaTest, failToRetrieveStringViewWithoutGuard)
+{
+    auto result = plugin->call<std::string_view>("identity", "abc");
+
+    EXPECT_FALSE(result.hasValue());
+}
+
+TEST(LuaPluginPoolTest, concurrentCalls)
+{
+    constexpr std::size_t POOL_SIZE = 3;
+    constexpr int THREAD_COUNT = 8;
+    constexpr int CALL_COUNT = 200;
+    auto pool = ppplugin::LuaPluginPool::load("./lua_tests/test.lua", POOL_SIZE);
+    ASSERT_TRUE(pool.hasValue()) << ppplugin::test::errorOutput(pool);
+    EXPECT_EQ(pool->size(), POOL_SIZE);
+
+    std::atomic<int> successful_calls { 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        threads.emplace_back([&pool, &successful_calls]() {
+            for (int j = 0; j < CALL_COUNT; ++j) {
+                auto result = pool->call<bool>("accept_number_string_bool", j, "abc", true);
+                if (result.valueOr(false)) {
+                    ++successful_calls;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(successful_calls, THREAD_COUNT * CALL_COUNT);
+}
+
+TEST(LuaPluginPoolTest, failToLoadNonexistentFile)
+{
+    auto pool = ppplugin::LuaPluginPool::load("./lua_tests/does_not_exist.lua");
+
+    ASSERT_FALSE(pool.hasValue());
+    EXPECT_EQ(pool.error().code(), ppplugin::LoadErrorCode::fileNotFound);
+}
+
+TEST(LuaPluginPoolTest, shareTableWithAllStates)
+{
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.sharedGlobals.emplace("shared_config", ppplugin::LuaSharedTable { ppplugin::LuaSharedTable::Fields { { "answer", 42 } } });
+    auto pool = ppplugin::LuaPluginPool::load("./lua_tests/test.lua", 2, options);
+    ASSERT_TRUE(pool.hasValue()) << ppplugin::test::errorOutput(pool);
+
+    for (std::size_t i = 0; i < pool->size() * 2; ++i) {
+        EXPECT_EQ(pool->call<int>("access_global_table", "shared_config", "answer").valueOr(-1), 42);
+    }
+}
+
+TEST(LuaPluginPoolTest, applyLoadOptionsToAllStates)
+{
+    auto cache_directory = std::filesystem::temp_directory_path() / "ppplugin_pool_cache_test";
+    std::filesystem::remove_all(cache_directory);
+    ppplugin::LuaPlugin::LoadOptions options;
+    options.autoRun = false;
+    options.bytecodeCacheDirectory = cache_directory;
+    options.allocator = []() { return std::make_unique<ppplugin::LuaPoolAllocator>(); };
+    auto pool = ppplugin::LuaPluginPool::load("./lua_tests/test.lua", 2, options);
+    ASSERT_TRUE(pool.hasValue()) << ppplugin::test::errorOutput(pool);
+
+    for (std::size_t i = 0; i < pool->size() * 2; ++i) {
+        EXPECT_EQ(pool->call<int>("identity", 3).valueOr(-1), 3);
+    }
+    EXPECT_FALSE(std::filesystem::is_empty(cache_directory));
+
+    std::filesystem::remove_all(cache_directory);
+}
+
+class LuaSharedTableTest : public testing::Test {
+protected:
+    void SetUp() override
+    {
+        ppplugin::LuaPlugin::LoadOptions options;
+        options.sharedGlobals.emplace("shared_config", table);
+        auto load_result = ppplugin::LuaPlugin::load("./lua_tests/test.lua", options);
+        ASSERT_TRUE(load_result.hasValue()) << ppplugin::test::errorOutput(load_result);
+
+        plugin = std::make_unique<ppplugin::LuaPlugin>(std::move(load_result.value()));
+    }
+
+protected:
+    const ppplugin::LuaSharedTable table {
+        ppplugin::LuaSharedTable::Array { 10, 2.5, "c" },
+        ppplugin::LuaSharedTable::Fields {
+            { "name", "abc" },
+            { "enabled", true },
+            { "nested", ppplugin::LuaSharedTable { ppplugin::LuaSharedTable::Fields { { "value", 7 } } } },
+        },
+    };
+    std::unique_ptr<ppplugin::LuaPlugin> plugin;
+};
+
+TEST_F(LuaSharedTableTest, accessSharedGlobal)
+{
+    EXPECT_EQ(plugin->call<int>("access_global_table", "shared_config", 1).valueOr(-1), 10);
+    EXPECT_EQ(plugin->call<double>("access_global_table", "shared_config", 2).valueOr(-1.0), 2.5);
+    EXPECT_EQ(plugin->call<std::string>("access_global_table", "shared_config", 3).valueOr(""), "c");
+    EXPECT_EQ(plugin->call<std::string>("access_global_table", "shared_config", "name").valueOr(""), "abc");
+    EXPECT_TRUE(plugin->call<bool>("access_global_table", "shared_config", "enabled").valueOr(false));
+    EXPECT_EQ(plugin->call<int>("length", table).valueOr(-1), 3);
+}
+
+TEST_F(LuaSharedTableTest, accessNestedTable)
+{
+    auto nested = plugin->call<ppplugin::LuaSharedTable>("access_table", table, "nested");
+
+    ASSERT_TRUE(nested.hasValue()) << ppplugin::test::errorOutput(nested);
+    EXPECT_EQ(plugin->call<int>("access_table", *nested, "value").valueOr(-1), 7);
+}
+
+TEST_F(LuaSharedTableTest, iterateSharedTable)
+{
+    auto count = plugin->call<int>("count_entries", table);
+
+    ASSERT_TRUE(count.hasValue()) << ppplugin::test::errorOutput(count);
+    EXPECT_EQ(count.valueOr(-1), 6);
+}
+
+TEST_F(LuaSharedTableTest, failToModifySharedTable)
+{
+    auto result = plugin->call<void>("write_buffer", table, "name", "xyz");
+
+    EXPECT_FALSE(result.hasValue());
+    EXPECT_EQ(plugin->call<std::string>("access_table", table, "name").valueOr(""), "abc");
+}
+
+TEST_F(LuaSharedTableTest, retrieveSameData)
+{
+    auto result = plugin->call<ppplugin::LuaSharedTable>("identity", table);
+
+    ASSERT_TRUE(result.hasValue()) << ppplugin::test::errorOutput(result);
+    EXPECT_EQ(&result->array(), &table.array());
+}
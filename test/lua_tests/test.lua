@@ -39,3 +39,64 @@ end
 function identity(x)
     return x
 end
+
+function create_table(size)
+    local t = {}
+    for i = 1, size do
+        t[i] = tostring(i)
+    end
+    return #t
+end
+
+function create_array(size)
+    local t = {}
+    for i = 1, size do
+        t[i] = i - 1
+    end
+    return t
+end
+
+function scale_buffer(buffer, factor)
+    for i = 1, #buffer do
+        buffer[i] = buffer[i] * factor
+    end
+    return buffer
+end
+
+function write_buffer(buffer, index, value)
+    buffer[index] = value
+end
+
+function sum_requested_values(count)
+    local sum = 0
+    for i = 1, count do
+        sum = sum + coroutine.yield(i)
+    end
+    return sum
+end
+
+function fail_after_yield()
+    coroutine.yield()
+    error("failure after yield")
+end
+
+function loop_forever()
+    while true do
+    end
+end
+
+function length(t)
+    return #t
+end
+
+function access_global_table(name, key)
+    return _G[name][key]
+end
+
+function count_entries(t)
+    local count = 0
+    for _ in pairs(t) do
+        count = count + 1
+    end
+    return count
+end
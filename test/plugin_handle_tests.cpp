@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <ppplugin/plugin_handle.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(PluginHandleTest, copiesShareInstance)
+{
+    ppplugin::PluginHandle<std::string> handle { std::string { "a" } };
+    auto copy = handle;
+
+    copy.replace(std::string { "b" });
+
+    EXPECT_EQ(*handle.get(), "b");
+    EXPECT_EQ(handle.version(), 1);
+    EXPECT_EQ(copy.version(), 1);
+}
+
+TEST(PluginHandleTest, replacedInstanceStaysValidWhileInUse)
+{
+    ppplugin::PluginHandle<std::string> handle { std::string { "old" } };
+
+    auto in_use = handle.get();
+    handle.replace(std::string { "new" });
+
+    EXPECT_EQ(*in_use, "old");
+    EXPECT_EQ(*handle.get(), "new");
+    EXPECT_EQ(handle->size(), 3);
+}
+
+TEST(PluginHandleTest, concurrentReadDuringReplace)
+{
+    constexpr int REPLACEMENTS = 1000;
+    ppplugin::PluginHandle<std::string> handle { std::string { "0" } };
+
+    std::atomic<bool> done { false };
+    std::atomic<int> invalid_reads { 0 };
+    auto reader = [&]() {
+        while (!done) {
+            auto plugin = handle.read();
+            if (plugin->empty() || plugin->find_first_not_of("0123456789") != std::string::npos) {
+                ++invalid_reads;
+            }
+        }
+    };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back(reader);
+    }
+    for (int i = 1; i <= REPLACEMENTS; ++i) {
+        handle.replace(std::to_string(i));
+    }
+    done = true;
+    for (auto& thread : readers) {
+        thread.join();
+    }
+
+    EXPECT_EQ(invalid_reads, 0);
+    EXPECT_EQ(handle.version(), REPLACEMENTS);
+    EXPECT_EQ(*handle.read(), std::to_string(REPLACEMENTS));
+}
+
+TEST(PluginHandleTest, replacedInstanceDestroyedAfterLastRead)
+{
+    auto destroyed = std::make_shared<int>();
+    std::weak_ptr<int> old_instance = destroyed;
+    ppplugin::PluginHandle<std::shared_ptr<int>> handle { std::move(destroyed) };
+
+    {
+        auto access = handle.read();
+        std::thread { [&handle]() { handle.replace(std::make_shared<int>()); } }.join();
+        // reader still active, destruction is deferred
+        EXPECT_FALSE(old_instance.expired());
+        EXPECT_TRUE(*access);
+    }
+
+    EXPECT_TRUE(old_instance.expired());
+}
@@ -0,0 +1,272 @@
+#include "test_helper.h"
+
+#include <gtest/gtest.h>
+
+#include <ppplugin/plugin_manager.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+void writeFile(const std::filesystem::path& path, const std::string& content)
+{
+    // write to temporary file first and move to avoid reading incomplete file
+    auto temporary_path = path;
+    temporary_path += ".tmp";
+    std::ofstream { temporary_path } << content;
+    std::filesystem::rename(temporary_path, path);
+}
+
+template <typename P>
+void waitForReload(const ppplugin::PluginHandle<P>& plugin, std::uint64_t version)
+{
+    constexpr auto TIMEOUT = std::chrono::seconds { 5 };
+    auto start = std::chrono::steady_clock::now();
+    while (plugin.version() < version && std::chrono::steady_clock::now() - start < TIMEOUT) {
+        std::this_thread::sleep_for(std::chrono::milliseconds { 10 });
+    }
+}
+} // namespace
+
+TEST(PluginManagerTest, loadPluginByExtension)
+{
+    ppplugin::PluginManager manager;
+
+    auto c_plugin = manager.loadPlugin("./c_tests/test.so");
+    auto cpp_plugin = manager.loadPlugin("./cpp_tests/test.so");
+    auto lua_plugin = manager.loadPlugin("./lua_tests/test.lua");
+    auto unknown_plugin = manager.loadPlugin("./unknown.txt");
+
+    ASSERT_TRUE(c_plugin.hasValue()) << ppplugin::test::errorOutput(c_plugin);
+    ASSERT_TRUE(cpp_plugin.hasValue()) << ppplugin::test::errorOutput(cpp_plugin);
+    ASSERT_TRUE(lua_plugin.hasValue()) << ppplugin::test::errorOutput(lua_plugin);
+    EXPECT_TRUE((*c_plugin)->plugin<ppplugin::CPlugin>().has_value());
+    EXPECT_TRUE((*cpp_plugin)->plugin<ppplugin::CppPlugin>().has_value());
+    EXPECT_TRUE((*lua_plugin)->plugin<ppplugin::LuaPlugin>().has_value());
+    EXPECT_FALSE(unknown_plugin.hasValue());
+}
+
+TEST(PluginManagerTest, loadOnlyManagedPluginTypes)
+{
+    ppplugin::GenericPluginManager<ppplugin::LuaPlugin> manager;
+
+    auto lua_plugin = manager.loadPlugin("./lua_tests/test.lua");
+    auto c_plugin = manager.loadPlugin("./c_tests/test.so");
+
+    ASSERT_TRUE(lua_plugin.hasValue()) << ppplugin::test::errorOutput(lua_plugin);
+    EXPECT_TRUE((*lua_plugin)->plugin<ppplugin::LuaPlugin>().has_value());
+    ASSERT_FALSE(c_plugin.hasValue());
+    EXPECT_EQ(c_plugin.error().code(), ppplugin::LoadErrorCode::fileInvalid);
+}
+
+TEST(PluginManagerTest, loadPluginWithOptions)
+{
+    ppplugin::PluginManager manager;
+    ppplugin::PluginManager::LoadOptions options;
+    options.sharedLibrary.binding = ppplugin::CPlugin::LoadOptions::Binding::now;
+    options.sharedLibrary.indexSymbols = true;
+    const std::vector<std::filesystem::path> paths { "./c_tests/test.so", "./cpp_tests/test.so" };
+
+    auto results = manager.loadAll(paths, 0, options);
+
+    ASSERT_EQ(results.size(), 2);
+    for (const auto& result : results) {
+        ASSERT_TRUE(result.plugin.hasValue()) << ppplugin::test::errorOutput(result.plugin);
+    }
+    EXPECT_EQ(results[0].plugin->call<int>("add", 1, 2).valueOr(0), 3);
+}
+
+TEST(PluginManagerTest, loadAllPreservesOrder)
+{
+    ppplugin::PluginManager manager;
+    const std::vector<std::filesystem::path> paths {
+        "./c_tests/test.so",
+        "./lua_tests/does_not_exist.lua",
+        "./cpp_tests/test.so",
+        "./lua_tests/test.lua",
+        "./python_tests/test.py",
+    };
+
+    auto results = manager.loadAll(paths, 3);
+
+    ASSERT_EQ(results.size(), paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        EXPECT_EQ(results[i].path, paths[i]);
+        EXPECT_GE(results[i].loadTime.count(), 0);
+    }
+    EXPECT_TRUE(results[0].plugin.hasValue());
+    ASSERT_FALSE(results[1].plugin.hasValue());
+    EXPECT_EQ(results[1].plugin.error().code(), ppplugin::LoadErrorCode::fileNotFound);
+    EXPECT_TRUE(results[2].plugin.hasValue());
+    EXPECT_TRUE(results[3].plugin.hasValue());
+    EXPECT_TRUE(results[4].plugin.hasValue());
+
+    auto sum = results[2].plugin->call<int>("add", 1, 2);
+    ASSERT_TRUE(sum.hasValue()) << ppplugin::test::errorOutput(sum);
+    EXPECT_EQ(sum.valueOr(0), 3);
+}
+
+TEST(PluginManagerTest, loadAllFromDirectory)
+{
+    ppplugin::PluginManager manager;
+
+    auto results = manager.loadAll(std::filesystem::path { "./lua_tests" });
+
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results.front().path.filename(), "test.lua");
+    EXPECT_TRUE(results.front().plugin.hasValue());
+}
+
+TEST(PluginManagerTest, loadAllFromMissingDirectory)
+{
+    ppplugin::PluginManager manager;
+
+    auto results = manager.loadAll(std::filesystem::path { "./does_not_exist" });
+
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results.front().path, "./does_not_exist");
+    ASSERT_FALSE(results.front().plugin.hasValue());
+    EXPECT_EQ(results.front().plugin.error().code(), ppplugin::LoadErrorCode::fileNotFound);
+    EXPECT_TRUE(manager.plugins().empty());
+}
+
+TEST(PluginManagerTest, getPluginByName)
+{
+    ppplugin::PluginManager manager;
+
+    auto c_plugin = manager.loadPlugin("./c_tests/test.so", "c");
+    auto lua_plugin = manager.loadPlugin("./lua_tests/test.lua");
+    ASSERT_TRUE(c_plugin.hasValue()) << ppplugin::test::errorOutput(c_plugin);
+    ASSERT_TRUE(lua_plugin.hasValue()) << ppplugin::test::errorOutput(lua_plugin);
+
+    auto plugin = manager.get("c");
+    ASSERT_TRUE(plugin.has_value());
+    EXPECT_EQ(plugin->get().call<int>("add", 1, 2).valueOr(0), 3);
+    EXPECT_TRUE(manager.get("test").has_value());
+    EXPECT_FALSE(manager.get("unknown").has_value());
+
+    std::vector<std::string> names;
+    for (const auto& entry : manager.plugins()) {
+        names.push_back(entry.name);
+    }
+    EXPECT_EQ(names, (std::vector<std::string> { "c", "test" }));
+}
+
+TEST(PluginManagerTest, autoReloadModifiedPlugin)
+{
+    auto directory = std::filesystem::temp_directory_path() / "ppplugin_auto_reload_test";
+    std::filesystem::create_directories(directory);
+    auto script_path = directory / "reload.lua";
+    writeFile(script_path, "function get_version() return 1 end");
+
+    ppplugin::PluginManager manager { true };
+    auto plugin = manager.loadPlugin(script_path);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+    EXPECT_EQ(plugin->call<int>("get_version").valueOr(0), 1);
+    auto old_instance = plugin->get();
+
+    writeFile(script_path, "function get_version() return 2 end");
+    waitForReload(*plugin, 1);
+
+    EXPECT_EQ(plugin->version(), 1);
+    EXPECT_EQ(plugin->call<int>("get_version").valueOr(0), 2);
+    // instance which was in use before reload is unaffected
+    EXPECT_EQ(old_instance->call<int>("get_version").valueOr(0), 1);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PluginManagerTest, autoReloadModifiedSharedLibrary)
+{
+    auto directory = std::filesystem::temp_directory_path() / "ppplugin_library_reload_test";
+    std::filesystem::create_directories(directory);
+    auto library_path = directory / "reload.so";
+    std::filesystem::copy_file("./c_tests/test.so", library_path,
+        std::filesystem::copy_options::overwrite_existing);
+
+    ppplugin::PluginManager manager { true };
+    auto plugin = manager.loadPlugin(library_path);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+    EXPECT_EQ(plugin->call<int>("get_version").valueOr(0), 1);
+    auto old_instance = plugin->get();
+
+    // replace by moving to keep the old file intact while it is mapped
+    auto temporary_path = directory / "reload.tmp";
+    std::filesystem::copy_file("./c_tests/test_v2.so", temporary_path,
+        std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::rename(temporary_path, library_path);
+    waitForReload(*plugin, 1);
+
+    EXPECT_EQ(plugin->version(), 1);
+    EXPECT_EQ(plugin->call<int>("get_version").valueOr(0), 2);
+    EXPECT_EQ(old_instance->call<int>("get_version").valueOr(0), 1);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PluginManagerTest, moveAssignAutoReloadManager)
+{
+    auto directory = std::filesystem::temp_directory_path() / "ppplugin_move_reload_test";
+    std::filesystem::create_directories(directory);
+    auto script_path = directory / "reload.lua";
+    writeFile(script_path, "function get_version() return 1 end");
+
+    ppplugin::PluginManager manager { true };
+    ASSERT_TRUE(manager.loadPlugin(script_path).hasValue());
+    ppplugin::PluginManager other { true };
+    ASSERT_TRUE(other.loadPlugin(script_path, "other").hasValue());
+    // previous watcher must be stopped before its reload state is destroyed
+    manager = std::move(other);
+
+    auto plugin = manager.get("other");
+    ASSERT_TRUE(plugin.has_value());
+    EXPECT_FALSE(manager.get("reload").has_value());
+    writeFile(script_path, "function get_version() return 2 end");
+    waitForReload(plugin->get(), 1);
+
+    EXPECT_EQ(plugin->get().call<int>("get_version").valueOr(0), 2);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PluginManagerTest, reportFailedReload)
+{
+    auto directory = std::filesystem::temp_directory_path() / "ppplugin_failed_reload_test";
+    std::filesystem::create_directories(directory);
+    auto script_path = directory / "reload.lua";
+    writeFile(script_path, "function get_version() return 1 end");
+
+    std::mutex mutex;
+    std::condition_variable reloaded;
+    std::vector<bool> results;
+    ppplugin::PluginManager manager { true, [&](const std::filesystem::path& /*path*/, const ppplugin::Expected<void, ppplugin::LoadError>& result) {
+                                         const std::lock_guard lock { mutex };
+                                         results.push_back(result.hasValue());
+                                         reloaded.notify_one();
+                                     } };
+    auto plugin = manager.loadPlugin(script_path);
+    ASSERT_TRUE(plugin.hasValue()) << ppplugin::test::errorOutput(plugin);
+
+    auto wait_for_results = [&](std::size_t count) {
+        std::unique_lock lock { mutex };
+        reloaded.wait_for(lock, std::chrono::seconds { 5 }, [&]() { return results.size() >= count; });
+    };
+    writeFile(script_path, "function get_version(");
+    wait_for_results(1);
+    EXPECT_EQ(plugin->version(), 0);
+    writeFile(script_path, "function get_version() return 2 end");
+    wait_for_results(2);
+
+    const std::lock_guard lock { mutex };
+    EXPECT_EQ(results, (std::vector<bool> { false, true }));
+    EXPECT_EQ(plugin->call<int>("get_version").valueOr(0), 2);
+
+    std::filesystem::remove_all(directory);
+}
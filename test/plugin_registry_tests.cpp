@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <ppplugin/plugin_registry.h>
+
+#include <string>
+#include <vector>
+
+TEST(PluginRegistryTest, lookupByName)
+{
+    constexpr int PLUGIN_COUNT = 100;
+    ppplugin::PluginRegistry<std::string> registry;
+
+    for (int i = 0; i < PLUGIN_COUNT; ++i) {
+        auto name = "plugin" + std::to_string(i);
+        EXPECT_TRUE(registry.insert(name, ppplugin::PluginHandle<std::string> { std::string { name } }));
+    }
+
+    ASSERT_EQ(registry.size(), PLUGIN_COUNT);
+    for (int i = 0; i < PLUGIN_COUNT; ++i) {
+        auto name = "plugin" + std::to_string(i);
+        auto plugin = registry.get(name);
+        ASSERT_TRUE(plugin.has_value()) << name;
+        EXPECT_EQ(*plugin->get().read(), name);
+    }
+    EXPECT_FALSE(registry.get("plugin").has_value());
+    EXPECT_FALSE(registry.contains("plugin100"));
+}
+
+TEST(PluginRegistryTest, iterateInInsertionOrder)
+{
+    ppplugin::PluginRegistry<std::string> registry;
+    const std::vector<std::string> names { "c", "a", "b" };
+    for (const auto& name : names) {
+        registry.insert(name, ppplugin::PluginHandle<std::string> { std::string { name } });
+    }
+
+    EXPECT_FALSE(registry.insert("a", ppplugin::PluginHandle<std::string> { std::string { "new" } }));
+
+    std::vector<std::string> iterated_names;
+    for (const auto& entry : registry) {
+        iterated_names.push_back(entry.name);
+    }
+    EXPECT_EQ(iterated_names, names);
+    EXPECT_EQ(*registry.get("a")->get().read(), "new");
+}
@@ -0,0 +1,61 @@
+#include "test_helper.h"
+
+#include <gtest/gtest.h>
+
+#include <ppplugin/plugin.h>
+
+#include <string>
+
+TEST(GenericPluginTest, bindCFunction)
+{
+    auto c_plugin = ppplugin::CPlugin::load("./c_tests/test.so");
+    ASSERT_TRUE(c_plugin.hasValue()) << ppplugin::test::errorOutput(c_plugin);
+    ppplugin::Plugin plugin { std::move(*c_plugin) };
+
+    auto add = plugin.bind<int(int, int)>("add");
+
+    ASSERT_TRUE(add.hasValue()) << ppplugin::test::errorOutput(add);
+    EXPECT_EQ((*add)(1, 2).valueOr(0), 3);
+    EXPECT_EQ((*add)(3, 4).valueOr(0), 7);
+}
+
+TEST(GenericPluginTest, bindMissingCFunction)
+{
+    auto c_plugin = ppplugin::CPlugin::load("./c_tests/test.so");
+    ASSERT_TRUE(c_plugin.hasValue()) << ppplugin::test::errorOutput(c_plugin);
+    ppplugin::Plugin plugin { std::move(*c_plugin) };
+
+    auto function = plugin.bind<int(int, int)>("does_not_exist");
+
+    ASSERT_FALSE(function.hasValue());
+    EXPECT_EQ(function.error().code(), ppplugin::CallErrorCode::symbolNotFound);
+}
+
+TEST(GenericPluginTest, bindCppFunctionWithReference)
+{
+    auto cpp_plugin = ppplugin::CppPlugin::load("./cpp_tests/test.so");
+    ASSERT_TRUE(cpp_plugin.hasValue()) << ppplugin::test::errorOutput(cpp_plugin);
+    // C plugins would reject references at compile time
+    ppplugin::GenericPlugin<ppplugin::CppPlugin, ppplugin::LuaPlugin> plugin { std::move(*cpp_plugin) };
+
+    auto concat = plugin.bind<std::string(const std::string&, const std::string&)>("concat");
+
+    ASSERT_TRUE(concat.hasValue()) << ppplugin::test::errorOutput(concat);
+    EXPECT_EQ((*concat)("a", "b").valueOr(""), "ab");
+}
+
+TEST(GenericPluginTest, bindLuaFunction)
+{
+    auto lua_plugin = ppplugin::LuaPlugin::load("./lua_tests/test.lua");
+    ASSERT_TRUE(lua_plugin.hasValue()) << ppplugin::test::errorOutput(lua_plugin);
+    ppplugin::Plugin plugin { std::move(*lua_plugin) };
+
+    auto accept = plugin.bind<bool(int, std::string, bool)>("accept_number_string_bool");
+    auto missing = plugin.bind<int()>("does_not_exist");
+
+    ASSERT_TRUE(accept.hasValue()) << ppplugin::test::errorOutput(accept);
+    EXPECT_TRUE((*accept)(1, "a", true).valueOr(false));
+    // Lua functions are resolved on call
+    ASSERT_TRUE(missing.hasValue()) << ppplugin::test::errorOutput(missing);
+    EXPECT_FALSE((*missing)().hasValue());
+}
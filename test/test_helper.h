@@ -50,6 +50,14 @@ namespace detail {
 
 constexpr void noop() { }
 
+#if defined(__SANITIZE_ADDRESS__)
+constexpr bool IS_ADDRESS_SANITIZED = true;
+#elif defined(__has_feature)
+constexpr bool IS_ADDRESS_SANITIZED = __has_feature(address_sanitizer);
+#else
+constexpr bool IS_ADDRESS_SANITIZED = false;
+#endif
+
 template <typename Func, typename... Args>
 constexpr void forEachCombination(Func&& func, Args&&... args)
 {